@@ -16,10 +16,13 @@
  *					   (operating system, byteorder etc)
  *---------------------------[ Public Functions ]----------------------------
  * cmi_init
+ * cmi_attach
  * cmi_read
  * cmi_write
+ * cmi_read_data_descr_list
  * cmi_get_data_descr
  * cmi_set_data_descr
+ * cmi_release_data_descr
  * cmi_throwaway
  * cmi_get_base_a24
  *-------------------------------[ History ]---------------------------------
@@ -114,6 +117,10 @@ FUNCTION LOCAL USIGN32  cmi_correct_address
            IN USIGN32  address             /* address to correct */
          );
 static void irq_to_cntrl(LL_HANDLE* llHdl, USIGN8 irq_val );
+static void copy_from_dpram_a24( LL_HANDLE *llHdl, USIGN8 FAR *dst,
+								 USIGN8 FAR *src, USIGN16 len );
+static void copy_to_dpram_a24( LL_HANDLE *llHdl, USIGN8 FAR *dst,
+							   USIGN8 FAR *src, USIGN16 len );
 
 /*
  * Conversion macro for INTEL byteordering hosts when accessing a 32bit
@@ -139,6 +146,7 @@ static void irq_to_cntrl(LL_HANDLE* llHdl, USIGN8 irq_val );
 
 # define DELAY(ms)			 OSS_Delay (llHdl->osHdl, ms )		/* delay(ms) 	   delay some ms */
 # define TIMEOUT             PROFIDP_CMI_TIMEOUT
+# define ATTACH_DRAIN_MS     100     /* cmi_attach: max. wait for pending ACK */
 
 # define PS								  /* var for int masking */
 
@@ -225,6 +233,47 @@ possible return values:
 
 
 
+FUNCTION LOCAL VOID cmi_read_addresses
+        (
+			LL_HANDLE *llHdl   /* low level handle */
+        ) /* nodoc */
+/*-----------------------------------------------------------------------------
+FUNCTIONAL_DESCRIPTION
+
+This function takes the host and controller block addresses and sizes from
+the CMI descriptors. The host addresses must already be corrected.
+
+possible return values:
+
+- none
+
+-----------------------------------------------------------------------------*/
+{
+	llHdl->h_serv_descr       = (T_PROFI_SERVICE_DESCR FAR *)
+		((U_INT32_OR_64)(TWISTLONG_W(PB_MREAD_D32( llHdl->ma, H_PARAM_ADDR))));
+	llHdl->h_data_ptr         = (VOID                  FAR *)
+		((U_INT32_OR_64)(TWISTLONG_W(PB_MREAD_D32( llHdl->ma, H_DATA_ADDR))));
+	llHdl->h_data_descr_list  = (T_DATA_DESCR          FAR *)
+		((U_INT32_OR_64)(TWISTLONG_W(PB_MREAD_D32( llHdl->ma, H_DATA_DESCR_ADDR))));
+
+	llHdl->param_block_size   = MREAD_D16( llHdl->ma, H_PARAM_SIZE);
+	llHdl->data_block_size    = MREAD_D16( llHdl->ma, H_DATA_SIZE);
+	DBGWRT_2((DBH, "CMI init: param_bs=%x data_bs=%x\n", llHdl->param_block_size,
+		   llHdl->data_block_size));
+
+	/* --- determine controller param_addr and data_addr ------------------- */
+	llHdl->c_serv_descr   = (T_PROFI_SERVICE_DESCR FAR *)
+		(cmi_correct_address (llHdl, TWISTLONG_W(PB_MREAD_D32( llHdl->ma, C_PARAM_ADDR))));
+
+	llHdl->c_data_ptr     = (VOID FAR *)
+		(cmi_correct_address (llHdl, TWISTLONG_W(PB_MREAD_D32( llHdl->ma, C_DATA_ADDR))));
+
+	DBGWRT_2((DBH, "CMI init: C_SDB=%lx C_DATA_BLOCK=%lx\n",
+		  TWISTLONG_W(PB_MREAD_D32( llHdl->ma, C_PARAM_ADDR)), TWISTLONG_W(PB_MREAD_D32( llHdl->ma, C_DATA_ADDR))));
+}
+
+
+
 FUNCTION PUBLIC PB_INT16 cmi_init
         (
 			LL_HANDLE *llHdl /*,   low level handle */
@@ -246,6 +295,7 @@ possible return values:
 -----------------------------------------------------------------------------*/
 {
 	u_int32  save;
+	u_int32  t;
 	/*--- init global controller base address ---*/
 
 	/*--- reset+start module ---*/
@@ -255,6 +305,8 @@ possible return values:
 	M57_RESET(llHdl->ma,0);
 	/* Controller needs 16us to start up */
 	DELAY(50);
+	llHdl->hw_wptr = DP_WPTR_INVALID;	/* window pointer reset */
+	llHdl->dataDescrValid = FALSE;		/* data descr list must be read again */
 
 	DBGWRT_2((DBH, "CMI init: base_a08=%lx\n", (void*)llHdl->ma));
 
@@ -287,6 +339,7 @@ possible return values:
 
 	/* --- get the start time for check timeout ---------------------------- */
 	llHdl->cTick_cmi_init = ACT_TICK;
+	t = dp_time_us( llHdl );
 
 
 	DBGWRT_2((DBH, "CMI init: wait controller ready\n"));
@@ -309,6 +362,8 @@ possible return values:
 			return(E_IF_NO_CNTRL_RES);
 	}
 
+	llHdl->tPhase[DP_T_CMI_READY] = dp_time_us( llHdl ) - t;
+
 	/* --- set host ready mask again --------------------------------------- */
 	PB_MWRITE_D32( llHdl->ma, H_READY_MASK, TWISTLONG_W(_H_READY_MASK_));
 
@@ -335,27 +390,7 @@ possible return values:
 		  TWISTLONG_W(PB_MREAD_D32( llHdl->ma, H_DATA_ADDR)),
 		  TWISTLONG_W(PB_MREAD_D32( llHdl->ma, H_DATA_DESCR_ADDR))));
 
-	llHdl->h_serv_descr       = (T_PROFI_SERVICE_DESCR FAR *)
-		((U_INT32_OR_64)(TWISTLONG_W(PB_MREAD_D32( llHdl->ma, H_PARAM_ADDR))));
-	llHdl->h_data_ptr         = (VOID                  FAR *)
-		((U_INT32_OR_64)(TWISTLONG_W(PB_MREAD_D32( llHdl->ma, H_DATA_ADDR))));
-	llHdl->h_data_descr_list  = (T_DATA_DESCR          FAR *)
-		((U_INT32_OR_64)(TWISTLONG_W(PB_MREAD_D32( llHdl->ma, H_DATA_DESCR_ADDR))));
-
-	llHdl->param_block_size   = MREAD_D16( llHdl->ma, H_PARAM_SIZE);
-	llHdl->data_block_size    = MREAD_D16( llHdl->ma, H_DATA_SIZE);
-	DBGWRT_2((DBH, "CMI init: param_bs=%x data_bs=%x\n", llHdl->param_block_size,
-		   llHdl->data_block_size));
-
-	/* --- determine controller param_addr and data_addr ------------------- */
-	llHdl->c_serv_descr   = (T_PROFI_SERVICE_DESCR FAR *)
-		(cmi_correct_address (llHdl, TWISTLONG_W(PB_MREAD_D32( llHdl->ma, C_PARAM_ADDR))));
-
-	llHdl->c_data_ptr     = (VOID FAR *)
-		(cmi_correct_address (llHdl, TWISTLONG_W(PB_MREAD_D32( llHdl->ma, C_DATA_ADDR))));
-
-	DBGWRT_2((DBH, "CMI init: C_SDB=%lx C_DATA_BLOCK=%lx\n",
-		  TWISTLONG_W(PB_MREAD_D32( llHdl->ma, C_PARAM_ADDR)), TWISTLONG_W(PB_MREAD_D32( llHdl->ma, C_DATA_ADDR))));
+	cmi_read_addresses( llHdl );
 
 	MWRITE_D8( llHdl->ma, H_RET_VAL, E_OK);
 
@@ -363,6 +398,7 @@ possible return values:
 
 
 	llHdl->cTick_cmi_init = ACT_TICK;
+	t = dp_time_us( llHdl );
 	DBGWRT_2((DBH, "CMI init: wait for controller config mode\n"));
 	while (MREAD_D8( llHdl->ma, C_STATE) != CONFIG_MODE){
 		/* --- wait until controller state is 'CONFIG_MODE' ---------------- */
@@ -372,6 +408,7 @@ possible return values:
 			return(E_IF_NO_CNTRL_RES);
 
 	}
+	llHdl->tPhase[DP_T_CMI_CONFIG_MODE] = dp_time_us( llHdl ) - t;
 
 	if ( 0x0 != MREAD_D8( llHdl->ma, C_ID ) ) {
 		DBGWRT_2((DBH, "CMI init: C_ID was not = 0, set C_ID = 0 ...\n"));
@@ -387,6 +424,97 @@ possible return values:
 
 
 
+FUNCTION PUBLIC PB_INT16 cmi_attach
+        (
+			LL_HANDLE *llHdl   /* low level handle */
+        ) /* nodoc */
+
+/*-----------------------------------------------------------------------------
+FUNCTIONAL_DESCRIPTION
+This function attaches the host cmi driver to a controller which was
+initialized by cmi_init before and is still running. The controller is not
+reset, the block addresses are taken from the CMI descriptors.
+The mailbox may be left busy by the previous driver instance: the ACK of a
+request still pending is awaited (max. ATTACH_DRAIN_MS) and taken, CON/INDs
+already received by the controller are discarded and H_ID is cleared.
+
+possible return values:
+
+- E_OK                             cmi is attached
+- E_IF_NO_CNTRL_RES                controller not initialized or not running
+-----------------------------------------------------------------------------*/
+{
+	u_int8 state, id;
+	u_int32 ms = 0;
+	T_PROFI_SERVICE_DESCR sdb;
+	USIGN16 len;
+
+	llHdl->hw_wptr = DP_WPTR_INVALID;	/* window pointer unknown */
+	llHdl->dataDescrValid = FALSE;		/* data descr list must be read again */
+
+	SET_WINDOW(llHdl->ma,COMM_OFF);
+	llHdl->Wcmi = (T_CMI_DESCRIPTOR *)(llHdl->ma);
+
+	/* --- controller must have been initialized from this address --------- */
+	state = MREAD_D8( llHdl->ma, C_STATE);
+	if ( PB_MREAD_D32( llHdl->ma, H_READY_MASK) != TWISTLONG_W(_H_READY_MASK_) ||
+		 PB_MREAD_D32( llHdl->ma, C_READY_MASK) != TWISTLONG_W(_C_READY_MASK_) ||
+		 PB_MREAD_D32( llHdl->ma, H_BASE_ADDRESS) != DUMMY_BASE+COMM_OFF ||
+		 MREAD_D8( llHdl->ma, C_RET_VAL) != E_OK ||
+		 (state != CONFIG_MODE && state != COMM_MODE) ) {
+		DBGWRT_ERR((DBH, " *** CMI attach: controller not running, state=%02x\n", state));
+		return(E_IF_NO_CNTRL_RES);
+	}
+
+	llHdl->h_base_address = DUMMY_BASE+COMM_OFF;
+	llHdl->c_base_address = TWISTLONG_W(PB_MREAD_D32( llHdl->ma, C_BASE_ADDRESS));
+
+	cmi_read_addresses( llHdl );
+
+	/* --- drain mailbox, nobody waits for its CON/INDs and ACKs anymore --- */
+	while( ms < 2 * ATTACH_DRAIN_MS ) {
+		SET_WINDOW(llHdl->ma,COMM_OFF);
+		id = MREAD_D8( llHdl->ma, H_ID );
+
+		if ( id == 0xf0 || (ms >= ATTACH_DRAIN_MS &&
+							MREAD_D8( llHdl->ma, H_SEMA) != _IDLE) ) {
+			/* request of previous instance acked (or given up) */
+			DBGWRT_ERR((DBH, " *** CMI attach: drop request, rv=%x\n",
+						MREAD_D8( llHdl->ma, H_RET_VAL) ));
+			MWRITE_D8( llHdl->ma, H_RET_VAL, E_OK);
+			MWRITE_D8( llHdl->ma, H_SEMA, _IDLE);
+		}
+		else if ( MREAD_D8( llHdl->ma, C_SEMA) != _IDLE ) {
+			len = sizeof(llHdl->con_buf);
+			if ( cmi_read( llHdl, &sdb, llHdl->con_buf, &len ) == CON_IND_RECEIVED ) {
+				DBGWRT_ERR((DBH, " *** CMI attach: drop CON/IND service=%02x "
+							"primitive=%02x\n", sdb.service, sdb.primitive ));
+			}
+			else {
+				SET_WINDOW(llHdl->ma,COMM_OFF);
+				MWRITE_D8( llHdl->ma, C_SEMA, _IDLE);
+			}
+		}
+		else if ( id == 0 && MREAD_D8( llHdl->ma, H_SEMA) != _IDLE ) {
+			/* request not acked yet */
+			DELAY(1);
+			ms++;
+			continue;
+		}
+		else if ( id == 0 )
+			break;
+
+		SET_WINDOW(llHdl->ma,COMM_OFF);
+		MWRITE_D8( llHdl->ma, H_ID, 0 );
+		ms++;
+	}
+
+	DBGWRT_2((DBH, "CMI attach: exit ok\n"));
+	return(E_OK);
+}
+
+
+
 FUNCTION PUBLIC PB_INT16 cmi_read
          (
 								LL_HANDLE	*llHdl,  /* low level handle */
@@ -593,6 +721,110 @@ possible return values:
 }
 
 
+FUNCTION PUBLIC PB_INT16 cmi_wait_ack
+         (
+							  LL_HANDLE	  *llHdl    /* low level handle */
+         ) /* nodoc */
+
+/*-----------------------------------------------------------------------------
+FUNCTIONAL_DESCRIPTION
+This function waits for the ACK of a request written by cmi_write without
+waiting. The ISR-Task has set the host semaphore to _IDLE and stored the
+result of the controller in llHdl->reqRetVal. On timeout the request is
+taken back with the window pointer semaphore taken, unless the ACK arrived
+meanwhile.
+
+possible return values:
+- E_OK                    -> no error occured
+- E_IF_NO_CNTRL_RES       -> controller does not respond
+- E_IF_xxxxxxxxxxxxx      -> controller interface errors
+-----------------------------------------------------------------------------*/
+{
+	LOCAL_VARIABLES
+
+	PB_INT16 ret_val;
+
+	FUNCTION_BODY
+
+	if ((OSS_SemWait( llHdl->osHdl, llHdl->req_con_f0_semP, 5000 )) != 0) {
+		semTake( llHdl->windowPointerSemId, WAIT_FOREVER );
+		if (llHdl->reqPending) {
+			DBGWRT_ERR((DBH," *** cmi_wait_ack: Error or Timeout REQ/CON semaphore\n"));
+			SET_WINDOW(llHdl->ma, COMM_OFF);
+			MWRITE_D8( llHdl->ma, H_SEMA, _IDLE);
+			llHdl->reqPending = FALSE;
+			semGive( llHdl->windowPointerSemId );
+			return(E_IF_NO_CNTRL_RES);
+		}
+		/* ACK arrived meanwhile */
+		OSS_SemWait( llHdl->osHdl, llHdl->req_con_f0_semP, OSS_SEM_NOWAIT );
+		semGive( llHdl->windowPointerSemId );
+	}
+
+	ret_val = (PB_INT16) llHdl->reqRetVal;
+	DBGWRT_1((DBH," H_RET_VAL = %04x \n", ret_val));
+
+	if( ret_val != E_OK )
+		ret_val = PB_ERR(ret_val); /* PB_ERR does nothing  make a 057:000 error number */
+
+	return(ret_val);
+}
+
+
+FUNCTION PUBLIC PB_INT16 cmi_read_data_descr_list
+        (
+			LL_HANDLE*      llHdl               /* low level handle */
+        ) /* nodoc */
+
+/*----------------------------------------------------------------------------
+FUNCTIONAL_DESCRIPTION
+This function reads the CMI data description list once into the host copy
+llHdl->dataDescr (id, corrected data address, data size). The list is static
+once the controller is configured, so cmi_get_data_descr/cmi_set_data_descr
+only need to access the semaphores and the data in the DPRAM.
+
+possible return values:
+- E_OK                          -> OK
+----------------------------------------------------------------------------*/
+{
+	LOCAL_VARIABLES
+
+	PB_INT16       i=0;                       /* loop variable */
+	USIGN8         id;
+	USIGN8 Wh_data_descr_list =
+		(USIGN8) (((USIGN32)llHdl->h_data_descr_list)&0x7f);
+
+	FUNCTION_BODY
+
+	/*------------------------------------------------------------------+
+    |  Warning: works only if the entire array is smaller than the 128  |
+    |  byte window and does not cross a 128 byte boundary               |
+    +------------------------------------------------------------------*/
+	SET_WINDOW(llHdl->ma, ((USIGN32)llHdl->h_data_descr_list - DUMMY_BASE));
+
+	while( i < CMI_MAX_DATA_DESCR &&
+		   (id = MREAD_D8( llHdl->ma, Wh_data_descr_list + D_ID + (i * T_DATA_DESC_LEN))) != 0){
+
+		llHdl->dataDescr[i].id   = id;
+		llHdl->dataDescr[i].size = MREAD_D16(llHdl->ma, Wh_data_descr_list + D_DATA_SIZE +
+											 (i * T_DATA_DESC_LEN));
+		llHdl->dataDescr[i].addr = (USIGN8 FAR*)
+			cmi_correct_address(llHdl, TWISTLONG_W(
+									 PB_MREAD_D32(llHdl->ma, Wh_data_descr_list + D_DATA_ADDR +
+												  (i * T_DATA_DESC_LEN))));
+
+		DBGWRT_2((DBH, "cmi_read_data_descr_list: idx=%d id=%02x size=%x ptr=%lx\n",
+				  i, id, llHdl->dataDescr[i].size, llHdl->dataDescr[i].addr));
+		i++;
+	}
+
+	llHdl->dataDescrNum   = (u_int8) i;
+	llHdl->dataDescrValid = TRUE;
+
+	return(E_OK);
+}
+
+
 FUNCTION PUBLIC PB_INT16 cmi_get_data_descr
         (
 			LL_HANDLE*      llHdl,              /* low level handle */
@@ -617,64 +849,60 @@ possible return values:
 {
 	LOCAL_VARIABLES
 
-	PB_INT16       i=0;                       /* loop variable */
-	USIGN8         id;
-	USIGN8  FAR *h_data_descr_ptr;
+	PB_INT16       i;                         /* loop variable */
+	USIGN8         sema_h;                    /* offset of host semaphore */
+	DATA_DESCR_ENTRY *dd;
 	USIGN8 Wh_data_descr_list =
 		(USIGN8) (((USIGN32)llHdl->h_data_descr_list)&0x7f);
 
 	FUNCTION_BODY
 
-	/*------------------------------------------------------------------+
-    |  Warning: works only if the entire array is smaller than the 128  |
-    |  byte window and does not cross a 128 byte boundary               |
-    +------------------------------------------------------------------*/
-	SET_WINDOW(llHdl->ma, ((USIGN32)llHdl->h_data_descr_list - DUMMY_BASE));
-
 	DBGWRT_2((DBH, "cmi_get_data_descr: id=%d off=%x size=%x ",
 		   data_descr_id, offset, *data_descr_size));
 
-	while( (id = MREAD_D8( llHdl->ma, Wh_data_descr_list + D_ID + (i * T_DATA_DESC_LEN))) != 0){
-		if (id == data_descr_id){
+	if (!llHdl->dataDescrValid)
+		cmi_read_data_descr_list(llHdl);
 
-			MWRITE_D8( llHdl->ma, Wh_data_descr_list + D_SEMA_H + (i * T_DATA_DESC_LEN), 0xaa);
+	/* search data description in host copy of list */
+	for (i = 0; i < llHdl->dataDescrNum; i++)
+		if (llHdl->dataDescr[i].id == data_descr_id)
+			break;
 
-			/*--- check controller semaphore ---*/
-			if (MREAD_D8(llHdl->ma, Wh_data_descr_list + D_SEMA_C + (i * T_DATA_DESC_LEN))){
-				MWRITE_D8( llHdl->ma, Wh_data_descr_list + D_SEMA_H + (i * T_DATA_DESC_LEN), 0x00);
-				return(E_IF_SERVICE_CONSTR_CONFLICT);
-			}
+	if (i == llHdl->dataDescrNum)
+		return(E_IF_SERVICE_NOT_SUPPORTED);
 
-			/* assign data pointer */
-			h_data_descr_ptr = (USIGN8 FAR*)
-				cmi_correct_address(llHdl, TWISTLONG_W(
-										 PB_MREAD_D32(llHdl->ma, Wh_data_descr_list + D_DATA_ADDR +
-										                       (i * T_DATA_DESC_LEN))));
-
-			/* check datasize, if size to long limit it to max length */
-			if (*data_descr_size > (MREAD_D16(llHdl->ma, Wh_data_descr_list + D_DATA_SIZE +
-			                                 (i * T_DATA_DESC_LEN))) - offset){
-				*data_descr_size = MREAD_D16(llHdl->ma, Wh_data_descr_list + D_DATA_SIZE +
-			                                 (i * T_DATA_DESC_LEN));
-			}
+	dd     = &llHdl->dataDescr[i];
+	sema_h = Wh_data_descr_list + D_SEMA_H + (i * T_DATA_DESC_LEN);
+
+	if (offset >= dd->size)
+		return(E_IF_INVALID_DATA_SIZE);
 
-			DBGWRT_2((DBH, "idx=%d ptr=%lx\n", i, h_data_descr_ptr));
-			copy_from_dpram(llHdl, (USIGN8 FAR*) data_descr_ptr,
-							(USIGN8 FAR*) &h_data_descr_ptr[offset],
-							*data_descr_size
-							);
+	SET_WINDOW(llHdl->ma, ((USIGN32)llHdl->h_data_descr_list - DUMMY_BASE));
 
-			SET_WINDOW(llHdl->ma,
-/*!!added llHdl-> */   ((USIGN32)llHdl->h_data_descr_list - DUMMY_BASE));
-			/* lock semaphore while reading from all channels */
-			if (!llHdl->allCh)
-				MWRITE_D8( llHdl->ma, Wh_data_descr_list + D_SEMA_H + (i * T_DATA_DESC_LEN), 0x00);
+	MWRITE_D8( llHdl->ma, sema_h, 0xaa);
 
-			return(E_OK);
-		}
-		i++;
+	/*--- check controller semaphore ---*/
+	if (MREAD_D8(llHdl->ma, Wh_data_descr_list + D_SEMA_C + (i * T_DATA_DESC_LEN))){
+		MWRITE_D8( llHdl->ma, sema_h, 0x00);
+		return(E_IF_SERVICE_CONSTR_CONFLICT);
 	}
-	return(E_IF_SERVICE_NOT_SUPPORTED);
+
+	/* check datasize, if size to long limit it to rest of data block */
+	if (*data_descr_size > dd->size - offset)
+		*data_descr_size = dd->size - offset;
+
+	DBGWRT_2((DBH, "idx=%d ptr=%lx\n", i, dd->addr));
+	copy_from_dpram(llHdl, (USIGN8 FAR*) data_descr_ptr,
+					(USIGN8 FAR*) &dd->addr[offset],
+					*data_descr_size
+					);
+
+	SET_WINDOW(llHdl->ma, ((USIGN32)llHdl->h_data_descr_list - DUMMY_BASE));
+	/* lock semaphore while reading from all channels */
+	if (!llHdl->allCh)
+		MWRITE_D8( llHdl->ma, sema_h, 0x00);
+
+	return(E_OK);
 }
 
 
@@ -702,80 +930,103 @@ possible return values:
 {
 	LOCAL_VARIABLES
 
-	PB_INT16   i=0;     /* loop variable */
-	USIGN8    id;
-	USIGN8  FAR *h_data_descr_ptr;
-	/*T_DATA_DESCR FAR*/USIGN8 Wh_data_descr_list =
-		(USIGN8)(/*((u_int32) llHdl->ma)+*/(((USIGN32)llHdl->h_data_descr_list)&0x7f));
+	PB_INT16   i;       /* loop variable */
+	USIGN8     sema_h;  /* offset of host semaphore */
+	DATA_DESCR_ENTRY *dd;
+	USIGN8 Wh_data_descr_list =
+		(USIGN8)(((USIGN32)llHdl->h_data_descr_list)&0x7f);
 
 	FUNCTION_BODY
 
+	DBGWRT_2((DBH, "cmi_set_data_descr: id=%d off=%x size=%x ",
+		   data_descr_id, offset, data_descr_size));
 
+	if (!llHdl->dataDescrValid)
+		cmi_read_data_descr_list(llHdl);
+
+	/* search data description in host copy of list */
+	for (i = 0; i < llHdl->dataDescrNum; i++)
+		if (llHdl->dataDescr[i].id == data_descr_id)
+			break;
+
+	if (i == llHdl->dataDescrNum)
+		return(E_IF_SERVICE_NOT_SUPPORTED);
+
+	dd     = &llHdl->dataDescr[i];
+	sema_h = Wh_data_descr_list + D_SEMA_H + (i * T_DATA_DESC_LEN);
+
+	if ((data_descr_size + offset) > dd->size)
+		return(E_IF_INVALID_DATA_SIZE);
 
-	/*------------------------------------------------------------------+
-    |  Warning: works only if the entire array is smaller than the 128  |
-    |  byte window and does not cross a 128 byte boundary               |
-    +------------------------------------------------------------------*/
 	SET_WINDOW(llHdl->ma, ((USIGN32)llHdl->h_data_descr_list - DUMMY_BASE));
 
-	DBGWRT_2((DBH, "cmi_set_data_descr: id=%d off=%x size=%x ",
-		   data_descr_id, offset, data_descr_size));
+	MWRITE_D8( llHdl->ma, sema_h, 0xaa);
+
+	/*--- check controller semaphore ---*/
+	if (MREAD_D8(llHdl->ma, Wh_data_descr_list + D_SEMA_C + (i * T_DATA_DESC_LEN))){
+		MWRITE_D8( llHdl->ma, sema_h, 0x00);
+		DBGWRT_ERR((DBH, "\n *** cmi_set_data_descr: can't get controller semaphore\n"));
+		return(E_IF_SERVICE_CONSTR_CONFLICT);
+	}
 
-	DBGWRT_2((DBH, "cmi_set_data_descr: MREAD offset=%x ", (Wh_data_descr_list + D_ID + (i * T_DATA_DESC_LEN))));
+	DBGWRT_2((DBH, "cmi_set_data_descr: idx=%d ptr=%lx\n", i, dd->addr));
 
-	while( (id = MREAD_D8( llHdl->ma, (Wh_data_descr_list + D_ID + (i * T_DATA_DESC_LEN)))) != 0){
+	copy_to_dpram(llHdl,
+				  (USIGN8 FAR*) &dd->addr[offset],
+				  (USIGN8 FAR*) data_descr_ptr,
+				  data_descr_size
+				  );
 
-		DBGWRT_2((DBH, "\ncmi_set_data_descr: id=%02x\n", id));
+	SET_WINDOW(llHdl->ma, ((USIGN32)llHdl->h_data_descr_list - DUMMY_BASE));
+	/* lock semaphore while wirting to all channels */
+	if (!llHdl->allCh)
+		MWRITE_D8( llHdl->ma, sema_h, 0x00);
+	return(E_OK);
+}
 
-		if ( id == data_descr_id){
 
-			if ((data_descr_size + offset) >  MREAD_D16(llHdl->ma, Wh_data_descr_list + D_DATA_SIZE +
-			                                 (i * T_DATA_DESC_LEN)))
-				return(E_IF_INVALID_DATA_SIZE);
 
-			MWRITE_D8( llHdl->ma, Wh_data_descr_list + D_SEMA_H + (i * T_DATA_DESC_LEN), 0xaa);
+FUNCTION PUBLIC PB_INT16 cmi_release_data_descr
+        (
+			LL_HANDLE* llHdl,              /* low level handle */
+          IN  USIGN8   data_descr_id       /* id of data description      */
+        ) /* nodoc */
 
-			/*--- check controller semaphore ---*/
-			if (MREAD_D8(llHdl->ma, Wh_data_descr_list + D_SEMA_C + (i * T_DATA_DESC_LEN))){
-				DBGWRT_2((DBH, "cmi_set_data_descr: D_SEMA_C = %02x\n", MREAD_D8(llHdl->ma, Wh_data_descr_list + D_SEMA_C + (i * T_DATA_DESC_LEN))));
-				MWRITE_D8( llHdl->ma, Wh_data_descr_list + D_SEMA_H + (i * T_DATA_DESC_LEN), 0x00);
-				DBGWRT_ERR((DBH, "\n *** cmi_set_data_descr: can't get controller semaphore\n"));
-				return(E_IF_SERVICE_CONSTR_CONFLICT);
-			}
+/*----------------------------------------------------------------------------
+FUNCTIONAL_DESCRIPTION
 
-			h_data_descr_ptr = (USIGN8 FAR*)
-				cmi_correct_address(llHdl, TWISTLONG_W(
-										PB_MREAD_D32(llHdl->ma, (Wh_data_descr_list + D_DATA_ADDR +
-										                       (i * T_DATA_DESC_LEN)))));
-			/*---------------------------------*/
-			DBGWRT_2((DBH, ">*>*>cmi_set_data_descr: %08x", TWISTLONG_W(
-										PB_MREAD_D32(llHdl->ma, (Wh_data_descr_list + D_DATA_ADDR +
-										                       (i * T_DATA_DESC_LEN))))));
-
-#if 0
-			DBGWRT_2((DBH, ">*>*>cmi_set_data_descr: %08x", TWISTLONG_W(
-										MREAD_D32(llHdl->ma, (Wh_data_descr_list + D_DATA_ADDR +
-										                       (i * T_DATA_DESC_LEN))))));
-#endif /* if 0 */
-			/*---------------------------------*/
-			DBGWRT_2((DBH, "cmi_set_data_descr: idx=%d ptr=%lx\n", i, h_data_descr_ptr));
-
-			copy_to_dpram(llHdl,
-						  (USIGN8 FAR*) &h_data_descr_ptr[offset],
-						  (USIGN8 FAR*) data_descr_ptr,
-						  data_descr_size
-						  );
-
-			SET_WINDOW(llHdl->ma,
-						  ((USIGN32)llHdl->h_data_descr_list - DUMMY_BASE));
-			/* lock semaphore while wirting to all channels */
-			if (!llHdl->allCh)
-				MWRITE_D8( llHdl->ma, Wh_data_descr_list + D_SEMA_H + (i * T_DATA_DESC_LEN), 0x00);
-			return(E_OK);
-		}
-		i++;
-	}
-	return(E_IF_SERVICE_NOT_SUPPORTED);
+This function releases the host semaphore of a data description. It is
+used after several cmi_get_data_descr/cmi_set_data_descr calls done with
+llHdl->allCh set, which keep the host semaphore locked.
+
+possible return values:
+- E_OK                          -> OK
+- E_IF_SERVICE_NOT_SUPPORTED    -> service not supported
+
+----------------------------------------------------------------------------*/
+{
+	LOCAL_VARIABLES
+
+	PB_INT16   i;       /* loop variable */
+	USIGN8 Wh_data_descr_list =
+		(USIGN8)(((USIGN32)llHdl->h_data_descr_list)&0x7f);
+
+	FUNCTION_BODY
+
+	if (!llHdl->dataDescrValid)
+		cmi_read_data_descr_list(llHdl);
+
+	for (i = 0; i < llHdl->dataDescrNum; i++)
+		if (llHdl->dataDescr[i].id == data_descr_id)
+			break;
+
+	if (i == llHdl->dataDescrNum)
+		return(E_IF_SERVICE_NOT_SUPPORTED);
+
+	SET_WINDOW(llHdl->ma, ((USIGN32)llHdl->h_data_descr_list - DUMMY_BASE));
+	MWRITE_D8( llHdl->ma, Wh_data_descr_list + D_SEMA_H + (i * T_DATA_DESC_LEN), 0x00);
+
+	return(E_OK);
 }
 
 
@@ -786,6 +1037,145 @@ possible return values:
 # define FROM_DPRAM *dpdata
 #endif
 
+/*
+ * Direct (A24) DPRAM copy routines.
+ * The DPRAM is mapped completely into the second address space, so no
+ * window pointer is needed and the window pointer semaphore is not taken.
+ * The byte lanes used for odd addresses are the same as in A08 mode.
+ */
+static void copy_from_dpram_a24
+            (
+			 LL_HANDLE  *llHdl, /* low level handle */
+			 USIGN8 FAR *dst,	/* pointer to host memory */
+			 USIGN8 FAR *src,	/* pointer to dpram */
+			 USIGN16 len		/* number of bytes to copy (even or odd) */
+			) /* nodoc */
+{
+	USIGN16 *dstw;
+	USIGN16 t;
+	u_int32 offs = (USIGN32)src - DUMMY_BASE;	/* M57 local address */
+
+	DBGWRT_2((DBH, "copy_from_dpram_a24 offs=%lx len=%x\n", offs, len ));
+
+	if( offs & 0x1 ){
+		/*--- dpram address odd ---*/
+#if (defined(_LITTLE_ENDIAN_) && (!defined(MAC_BYTESWAP))) || \
+( defined(_BIG_ENDIAN_) && defined(MAC_BYTESWAP) )
+		*dst++ = DP_A24_B_READ( llHdl->maDpram, offs, 0 );
+#elif (defined(_BIG_ENDIAN_) && (!defined(MAC_BYTESWAP))) || \
+( defined(_LITTLE_ENDIAN_) && defined(MAC_BYTESWAP) )
+		*dst++ = DP_A24_B_READ( llHdl->maDpram, offs, 1 );
+#else
+# error "please specify either _BIG_ENDIAN_ or _LITTLE_ENDIAN_"
+#endif
+		offs++;
+		len--;
+	}
+	dstw = (USIGN16 *)dst;
+
+	while( len > 16 ){
+		t = DP_A24_W_READ( llHdl->maDpram, offs );
+		*dstw++ = TWISTWORD( t );
+		t = DP_A24_W_READ( llHdl->maDpram, offs + 2 );
+		*dstw++ = TWISTWORD( t );
+		t = DP_A24_W_READ( llHdl->maDpram, offs + 4 );
+		*dstw++ = TWISTWORD( t );
+		t = DP_A24_W_READ( llHdl->maDpram, offs + 6 );
+		*dstw++ = TWISTWORD( t );
+		t = DP_A24_W_READ( llHdl->maDpram, offs + 8 );
+		*dstw++ = TWISTWORD( t );
+		t = DP_A24_W_READ( llHdl->maDpram, offs + 10 );
+		*dstw++ = TWISTWORD( t );
+		t = DP_A24_W_READ( llHdl->maDpram, offs + 12 );
+		*dstw++ = TWISTWORD( t );
+		t = DP_A24_W_READ( llHdl->maDpram, offs + 14 );
+		*dstw++ = TWISTWORD( t );
+		offs += 16;
+		len  -= 16;
+	}
+	while( len > 1 ){
+		t = DP_A24_W_READ( llHdl->maDpram, offs );
+		*dstw++ = TWISTWORD( t );
+		offs += 2;
+		len  -= 2;
+	}
+	if( len ){					/* one byte remaining? */
+		dst = (USIGN8 *)dstw;
+
+#if (defined(_BIG_ENDIAN_) && (!defined(MAC_BYTESWAP))) || \
+( defined(_LITTLE_ENDIAN_) && defined(MAC_BYTESWAP) )
+		*dst++ = DP_A24_B_READ( llHdl->maDpram, offs, 0 );
+#elif (defined(_LITTLE_ENDIAN_) && (!defined(MAC_BYTESWAP))) || \
+( defined(_BIG_ENDIAN_) && defined(MAC_BYTESWAP) )
+		*dst++ = DP_A24_B_READ( llHdl->maDpram, offs, 1 );
+#else
+# error "please specify either _BIG_ENDIAN_ or _LITTLE_ENDIAN_"
+#endif
+	}
+}
+
+static void copy_to_dpram_a24
+            (
+			 LL_HANDLE  *llHdl, /* low level handle */
+			 USIGN8 FAR *dst,	/* pointer to dpram */
+			 USIGN8 FAR *src,	/* pointer to host memory */
+			 USIGN16 len		/* number of bytes to copy (even or odd) */
+			) /* nodoc */
+{
+	USIGN16 *srcw;
+	u_int32 offs = (USIGN32)dst - DUMMY_BASE;	/* M57 local address */
+
+	DBGWRT_2((DBH, "copy_to_dpram_a24 offs=%lx len=%x\n", offs, len ));
+
+	if( offs & 0x1 ){
+#if (defined(_LITTLE_ENDIAN_) && (!defined(MAC_BYTESWAP))) || \
+( defined(_BIG_ENDIAN_) && defined(MAC_BYTESWAP) )
+		DP_A24_B_WRITE( llHdl->maDpram, offs, *src++, 0 );
+#elif (defined(_BIG_ENDIAN_) && (!defined(MAC_BYTESWAP))) || \
+( defined(_LITTLE_ENDIAN_) && defined(MAC_BYTESWAP) )
+		DP_A24_B_WRITE( llHdl->maDpram, offs, *src++, 1 );
+#else
+# error "please specify either _BIG_ENDIAN_ or _LITTLE_ENDIAN_"
+#endif
+		offs++;
+		len--;
+	}
+	srcw = (USIGN16 *)src;
+
+	while( len > 16 ){
+		DP_A24_W_WRITE( llHdl->maDpram, offs,      TWISTWORD(srcw[0]) );
+		DP_A24_W_WRITE( llHdl->maDpram, offs + 2,  TWISTWORD(srcw[1]) );
+		DP_A24_W_WRITE( llHdl->maDpram, offs + 4,  TWISTWORD(srcw[2]) );
+		DP_A24_W_WRITE( llHdl->maDpram, offs + 6,  TWISTWORD(srcw[3]) );
+		DP_A24_W_WRITE( llHdl->maDpram, offs + 8,  TWISTWORD(srcw[4]) );
+		DP_A24_W_WRITE( llHdl->maDpram, offs + 10, TWISTWORD(srcw[5]) );
+		DP_A24_W_WRITE( llHdl->maDpram, offs + 12, TWISTWORD(srcw[6]) );
+		DP_A24_W_WRITE( llHdl->maDpram, offs + 14, TWISTWORD(srcw[7]) );
+		srcw += 8;
+		offs += 16;
+		len  -= 16;
+	}
+	while( len > 1 ){
+		DP_A24_W_WRITE( llHdl->maDpram, offs, TWISTWORD(*srcw) );
+		srcw++;
+		offs += 2;
+		len  -= 2;
+	}
+	if( len ){					/* one byte remaining? */
+		src = (USIGN8 *)srcw;
+
+#if (defined(_BIG_ENDIAN_) && (!defined(MAC_BYTESWAP))) || \
+( defined(_LITTLE_ENDIAN_) && defined(MAC_BYTESWAP) )
+		DP_A24_B_WRITE( llHdl->maDpram, offs, *src++, 0 );
+#elif (defined(_LITTLE_ENDIAN_) && (!defined(MAC_BYTESWAP))) || \
+( defined(_BIG_ENDIAN_) && defined(MAC_BYTESWAP) )
+		DP_A24_B_WRITE( llHdl->maDpram, offs, *src++, 1 );
+#else
+# error "please specify either _BIG_ENDIAN_ or _LITTLE_ENDIAN_"
+#endif
+	}
+}
+
 /* static */ void copy_from_dpram
             (
 			 LL_HANDLE  *llHdl, /* low level handle */
@@ -804,6 +1194,12 @@ possible return values:
 #endif
 	PS;							/* var to hold processor status mask */
 
+	/* direct DPRAM access, window pointer not needed */
+	if( llHdl->dpramDirect ){
+		copy_from_dpram_a24( llHdl, dst, src, len );
+		return;
+	}
+
 	/* check window pointer semaphore, because cmi_irq would destroy window ptr */
 	if( OK == semInfoGet( llHdl->windowPointerSemId, &info ) ) {
 		if( info.state.owner != taskIdSelf() ) {
@@ -822,7 +1218,7 @@ possible return values:
 	}
 
 	/*--- set window pointer to start address in dpram ---*/
-	DP_SET_WINDOW(llHdl->ma, ((USIGN32)src - DUMMY_BASE));
+	SET_WINDOW_PORT(llHdl->ma, ((USIGN32)src - DUMMY_BASE));
 
 	DBGWRT_2((DBH, "copy_from_dpram winptr=%lx len=%x\n",
 		   (USIGN32)src-DUMMY_BASE, len ));
@@ -930,6 +1326,12 @@ possible return values:
 */
 	PS;
 
+	/* direct DPRAM access, window pointer not needed */
+	if( llHdl->dpramDirect ){
+		copy_to_dpram_a24( llHdl, dst, src, len );
+		return;
+	}
+
 	/* check window pointer semaphore, because cmi_irq would destroy window ptr */
 	if( OK == semInfoGet( llHdl->windowPointerSemId, &info ) ) {
 		if( info.state.owner != taskIdSelf() ) {
@@ -950,7 +1352,7 @@ possible return values:
 
 
 	/*--- set window pointer to start address in dpram ---*/
-	DP_SET_WINDOW(llHdl->ma, ((USIGN32)dst - DUMMY_BASE));
+	SET_WINDOW_PORT(llHdl->ma, ((USIGN32)dst - DUMMY_BASE));
 	DBGWRT_2((DBH, "copy_to_dpram winptr=%lx len=%x\n",
 		   (USIGN32)dst-DUMMY_BASE, len ));
 
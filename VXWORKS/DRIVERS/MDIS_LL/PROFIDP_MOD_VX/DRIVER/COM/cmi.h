@@ -72,6 +72,12 @@ FUNCTION extern PUBLIC PB_INT16 cmi_init
         );
 
 
+FUNCTION extern PUBLIC PB_INT16 cmi_attach
+        (
+			LL_HANDLE *llHdl  /* low level handle */
+        );
+
+
 FUNCTION extern PUBLIC PB_INT16 cmi_read
          (
 								LL_HANDLE	*llHdl,  /* low level handle */
@@ -88,7 +94,17 @@ FUNCTION extern PUBLIC PB_INT16 cmi_write
 		  IN USIGN16                      data_len,
 		  IN PB_BOOL					  waitForAck					  
          );
+
+FUNCTION extern PUBLIC PB_INT16 cmi_wait_ack
+         (
+							  LL_HANDLE	  *llHdl    /* low level handle */
+         );
          
+FUNCTION extern PUBLIC PB_INT16 cmi_read_data_descr_list
+        (
+			LL_HANDLE*      llHdl               /* low level handle */
+        );
+
 FUNCTION extern PUBLIC PB_INT16 cmi_get_data_descr
         (
 			LL_HANDLE*      llHdl,              /* low level handle */
@@ -110,6 +126,13 @@ FUNCTION extern PUBLIC PB_INT16 cmi_set_data_descr
         );
 
 
+FUNCTION extern PUBLIC PB_INT16 cmi_release_data_descr
+        (
+			LL_HANDLE* llHdl,              /* low level handle */
+          IN  USIGN8   data_descr_id       /* id of data description      */
+        );
+
+
 FUNCTION extern PB_INT16 dpgdl_get_data_len
   (
   IN    PB_INT16     result,
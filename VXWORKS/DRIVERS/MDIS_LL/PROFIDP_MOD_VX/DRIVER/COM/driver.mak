@@ -30,7 +30,8 @@
 
 MAK_NAME=profidp_mod_vx
 
-MAK_SWITCH=$(SW_PREFIX)MAC_MEM_MAPPED
+MAK_SWITCH=$(SW_PREFIX)MAC_MEM_MAPPED \
+           $(SW_PREFIX)PROFIDP_TIMESTAMP \
 
 MAK_LIBS=$(LIB_PREFIX)$(MEN_LIB_DIR)/desc$(LIB_SUFFIX)	\
          $(LIB_PREFIX)$(MEN_LIB_DIR)/mbuf$(LIB_SUFFIX)	\
@@ -56,6 +57,7 @@ MAK_INCL=$(MEN_INC_DIR)/profidp_mod_vx_drv.h	\
          $(MEN_MOD_DIR)/cmi_struct.h       \
          $(MEN_MOD_DIR)/m57_firm.h	       \
          $(MEN_MOD_DIR)/m57segm.h	       \
+         $(MEN_MOD_DIR)/m57pcfg.h	       \
          $(MEN_MOD_DIR)/pci.h	           \
          $(MEN_MOD_DIR)/profidp_drv_int.h  \
          $(MEN_INC_DIR)/PROFIDP_MOD_VX/keywords.h \
@@ -31,6 +31,7 @@ MAK_SWITCH=$(SW_PREFIX)MAC_MEM_MAPPED \
            $(SW_PREFIX)ID_SW \
            $(SW_PREFIX)PLD_SW \
            $(SW_PREFIX)PROFIDP_VARIANT=PROFIDP_SW \
+           $(SW_PREFIX)PROFIDP_TIMESTAMP \
  
 
 MAK_LIBS=$(LIB_PREFIX)$(MEN_LIB_DIR)/desc$(LIB_SUFFIX)	\
@@ -57,6 +58,7 @@ MAK_INCL=$(MEN_INC_DIR)/profidp_mod_vx_drv.h	\
          $(MEN_MOD_DIR)/cmi_struct.h       \
          $(MEN_MOD_DIR)/m57_firm.h	       \
          $(MEN_MOD_DIR)/m57segm.h	       \
+         $(MEN_MOD_DIR)/m57pcfg.h	       \
          $(MEN_MOD_DIR)/pci.h	           \
          $(MEN_MOD_DIR)/profidp_drv_int.h  \
          $(MEN_INC_DIR)/PROFIDP/keywords.h \
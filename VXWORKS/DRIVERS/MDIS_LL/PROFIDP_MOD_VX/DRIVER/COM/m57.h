@@ -154,6 +154,28 @@
 			DP_DATA_W_WRITE(base_a08, (data & 0xffff));\
 		}
 
+/*---------------------------------------------------------------------+
+| Macros for A24 access mode                                           |
++---------------------------------------------------------------------*/
+/*----------------------------------------------------------------------
+ * DP_A24_x_READ/WRITE
+ * access (read or write) <type> at M57 local address <offs>
+ *  base_a24     - base address of M57 in A24 mode
+ *  adOffset     - byte lane within the word (same as for DP_DATA_B_xxx)
+ * no window pointer is involved
+ */
+#define DP_A24_B_READ( base_a24, offs, adOffset ) \
+		(MREAD_D8( base_a24, (((offs) & ~0x1L) + adOffset) ))
+
+#define DP_A24_W_READ( base_a24, offs ) \
+		(MREAD_D16( base_a24, (offs) ))
+
+#define DP_A24_B_WRITE( base_a24, offs, val, adOffset ) \
+		(MWRITE_D8( base_a24, (((offs) & ~0x1L) + adOffset), val ))
+
+#define DP_A24_W_WRITE( base_a24, offs, val ) \
+		(MWRITE_D16( base_a24, (offs), val ))
+
 /*----------------------------------------------------------------------
  * M57_IRQ_TO_MOD
  * Issue interrupt to M57
@@ -191,6 +213,20 @@
 	M57_IRQ_DISABLE(base_a08); M57_IRQ_ENABLE(base_a08)
 
 
+/*----------------------------------------------------------------------
+ * M57_A24_MODE_A20, M57_A24_IS_A20
+ * Set/check A20 (1MB) decoding of the A24 DPRAM space (CNTR_REG bit 5)
+ */
+#define M57_A24_MODE_A20( base_a08 )                                \
+    {                                                               \
+	MWRITE_D8( base_a08, CNTR_REG,                                  \
+        MREAD_D8( base_a08, CNTR_REG ) & (u_int8)(~(0x20|0x10)) );  \
+    }
+
+#define M57_A24_IS_A20( base_a08 ) \
+		!(MREAD_D8 ( base_a08, CNTR_REG ) & 0x20)
+
+
 /*----------------------------------------------------------------------
  * M57_RESET
  * reset module (0=Release Reset, 1=Perform Reset)
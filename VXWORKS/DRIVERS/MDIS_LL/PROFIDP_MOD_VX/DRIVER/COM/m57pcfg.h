@@ -0,0 +1,62 @@
+/***********************  I n c l u d e  -  F i l e  ************************
+ *
+ *         Name: m57pcfg.h
+ *
+ *       Author: ag
+ *
+ *  Description: Layout of precompiled PROFIBUS configuration for M57 module
+ *
+ *               Created by the host tool m57_cfgpack out of the binary
+ *               configuration of the Softing DP-Configurator. It can be
+ *               passed to PROFIDP_BLK_CONFIG instead of the binary
+ *               configuration.
+ *
+ *     Switches:
+ *
+ *---------------------------------------------------------------------------
+ * (c) Copyright 2000 by MEN mikro elektronik GmbH, Nuernberg, Germany
+ ****************************************************************************/
+
+#ifndef _M57PCFG_H
+#define _M57PCFG_H
+
+/*-----------------------------------------+
+| Header of precompiled configuration      |
++-----------------------------------------*/
+/*
+ * All values are stored in Motorola byte order (high, low).
+ *
+ * The header is followed by numDl download blocks. Each block is a
+ * complete T_DP_DOWNLOAD_REQ with its data, ready to be sent as
+ * DP_DOWNLOAD_LOC request. The first block holds the bus parameter set,
+ * the others a slave parameter set with alignment bytes already inserted.
+ * Each block is padded to an even length.
+ *
+ * hash is a CRC32 (as used for the firmware) of all bytes from
+ * maxBusParaLen to the end of the configuration.
+ */
+#define M57_PCFG_MAGIC			0x4d353743	/* 'M57C' */
+#define M57_PCFG_VERSION		1
+#define M57_PCFG_NUM_SLAVES		125			/* entries of chInfo */
+#define M57_PCFG_HASH_START		16			/* offset of maxBusParaLen */
+
+typedef struct {
+	u_int32		magic;			/* M57_PCFG_MAGIC */
+	u_int16		version;		/* M57_PCFG_VERSION */
+	u_int16		hdrLen;			/* sizeof(M57_PCFG_HDR) */
+	u_int32		size;			/* size of configuration incl. header */
+	u_int32		hash;			/* content hash, see above */
+	u_int16		maxBusParaLen;	/* for FMB_SET_CONFIGURATION */
+	u_int16		maxSlaveParaLen;/* for FMB_SET_CONFIGURATION */
+	u_int8		masterAddr;		/* master default address */
+	u_int8		lowestSlAddr;	/* lowest configured slave address */
+	u_int8		maxInLen;		/* max slave input len (word aligned) */
+	u_int8		maxOutLen;		/* max slave output len (word aligned) */
+	u_int8		numDl;			/* nbr of download blocks */
+	u_int8		_pad[3];
+	u_int8		masterClass2Name[32];	/* for DP_INIT_MASTER */
+	u_int8		chInfo[M57_PCFG_NUM_SLAVES][2];	/* num_in, num_out per address */
+	u_int8		_pad2[2];
+} M57_PCFG_HDR;
+
+#endif /* _M57PCFG_H */
@@ -47,7 +47,29 @@ typedef struct {
 typedef struct {
 	u_int32		sync_code;
 #define SYNC_CODE 0xdeadface
+#define SYNC_CODE_PACKED 0xdeadfacf	/* segment data packed, see below */
 	m57_segm	segment[1];		/* segments (more than one possible) */
 } m57_download;
 
+/*-----------------------------------------+
+| Packed segment data                      |
++-----------------------------------------*/
+/*
+ * With SYNC_CODE_PACKED, offset of a segment points to its packed data
+ * and length is the unpacked length. The packed data is a sequence of
+ * tokens, each segment starts with an empty history:
+ *
+ *   0x00..0x7f  n+1 literal words follow
+ *   0x80..0xbf  the following word, repeated (n & 0x3f) + 2 times
+ *   0xc0..0xff  (n & 0x3f) + 2 words copied from d+1 words back,
+ *               d is the following byte
+ *
+ * Words are stored in the byte order of the unpacked file.
+ */
+#define M57_PACK_RUN		0x80		/* first repeat token */
+#define M57_PACK_COPY		0xc0		/* first copy token */
+#define M57_PACK_MAXLIT		0x80		/* max words of literal token */
+#define M57_PACK_MAXREP		0x41		/* max words of repeat/copy token */
+#define M57_PACK_WINDOW		256			/* words of history for copy token */
+
 #endif /* _M57SEGM_H */
@@ -14,6 +14,7 @@
  *
  *---------------------------[ Public Functions ]----------------------------
  *  profi_init
+ *  profi_attach
  *  profi_snd_req_res
  *  profi_rcv_con_ind
  *  profi_set_data
@@ -137,6 +138,18 @@ FUNCTION_DECLARATIONS
 /*
 #include "pci.ext"
 */
+FUNCTION LOCAL PB_BOOL profi_data_conflict
+        (
+          LL_HANDLE   *llHdl,
+          INOUT u_int32 *triesP,
+          IN  u_int32  start
+        );
+FUNCTION LOCAL VOID profi_data_conflict_done
+        (
+          LL_HANDLE   *llHdl,
+          IN  u_int32  tries,
+          IN  u_int32  start
+        );
 
 EXPORT_DATA
 
@@ -178,6 +191,30 @@ FUNCTION_BODY
 
 
 
+FUNCTION GLOBAL PB_INT16 CALL_CONV profi_attach
+        (
+			LL_HANDLE  *llHdl
+        ) /* nodoc */
+
+/*----------------------------------------------------------------------------
+FUNCTIONAL_DESCRIPTION
+This function is used to attach the Host-Interface to a Controller which is
+already initialized and running, without reset.
+
+Possible return values:
+- E_OK                             -> interface is attached
+- E_IF_NO_CNTRL_RES                -> controller not running
+-----------------------------------------------------------------------------*/
+{
+LOCAL_VARIABLES
+
+FUNCTION_BODY
+
+	return cmi_attach(llHdl);
+}
+
+
+
 FUNCTION GLOBAL PB_INT16 CALL_CONV profi_end(VOID) /* nodoc */
 
 /*----------------------------------------------------------------------------
@@ -395,28 +432,54 @@ if ((sdb_ptr->layer     == FM7_USR  ) &&
 	return(CON_IND_RECEIVED);
 }
 
-extern u_int8 loop3;
-
 FUNCTION GLOBAL PB_INT16 CALL_CONV profi_rcv_con_ind_wait
          (
           					LL_HANDLE      *llHdl,
           OUT   T_PROFI_SERVICE_DESCR  FAR *sdb_ptr,
           INOUT VOID                   FAR *data_ptr,
           INOUT USIGN16                FAR *data_len
-         )
+         ) /* nodoc */
+
+/*----------------------------------------------------------------------------
+FUNCTIONAL_DESCRIPTION
+
+This function polls for the next Service-Indication or Service-Confirmation
+(for systems without interrupt). The DPRAM is checked once per system tick,
+not in a tight loop. The wait is limited by llHdl->conIndTimeout (ms).
+With interrupt, the ISR-Task reads the CON/INDs into the CON/IND buffer,
+PROFIDP_BLK_RCV_CON_IND_WAIT blocks on its semaphore instead.
+
+Possible return values:
+
+- CON_IND_RECEIVED        -> a confirmation or indication has been received
+- NO_CON_IND_RECEIVED     -> timeout, nothing has been received
+- E_IF_INVALID_DATA_SIZE  -> size of data block provided not sufficient
+
+----------------------------------------------------------------------------*/
 {
+LOCAL_VARIABLES
 	PB_INT16 ret_val;
-	u_int16 i;
-	
-	i = 0;
-
-	while( (ret_val = profi_rcv_con_ind(llHdl, sdb_ptr,data_ptr,data_len)) == 
-		  NO_CON_IND_RECEIVED) {
-		  	i++;
-			/* ; */
+	u_int64  start;
+
+FUNCTION_BODY
+	start = dp_time64_us( llHdl );
+	while( 1 ) {
+		semTake( llHdl->windowPointerSemId, WAIT_FOREVER );
+		ret_val = profi_rcv_con_ind( llHdl, sdb_ptr, data_ptr, data_len );
+		SET_WINDOW(llHdl->ma, llHdl->current_wptr);
+		semGive( llHdl->windowPointerSemId );
+
+		if ( ret_val != NO_CON_IND_RECEIVED )
+			return(ret_val);
+		if ( (dp_time64_us( llHdl ) - start) / 1000 >= llHdl->conIndTimeout )
+			break;
+
+		/* don't load the bus, next check after one tick */
+		OSS_Delay( llHdl->osHdl, 1 );
 	}
-	
-	return ret_val;
+
+	DBGWRT_2((DBH, "profi_rcv_con_ind_wait: timeout\n"));
+	return(NO_CON_IND_RECEIVED);
 }
 
 FUNCTION GLOBAL PB_INT16 CALL_CONV profi_set_data
@@ -446,18 +509,20 @@ possible return values:
 {
 LOCAL_VARIABLES
 	PB_INT16 err;
+	u_int32  tries = 0;
+	u_int32  start = 0;
 
 FUNCTION_BODY
-    llHdl->cTick_pb_set_get_data = ACT_TICK;
-	
     while ((err = cmi_set_data_descr(llHdl,data_id,offset,data_size,data_ptr)) 
 		   == E_IF_SERVICE_CONSTR_CONFLICT) {
 		/* retry while semaphore busy */
-		if ( (int32) (ACT_TICK - llHdl->cTick_pb_set_get_data) >= ((int32) (5 * TICK_RATE)) ) {
+		if ( tries == 0 )
+			start = ACT_TICK;
+		if ( profi_data_conflict( llHdl, &tries, start ) ) {
 			return(E_IF_SERVICE_CONSTR_CONFLICT);
 		}
 	}
-
+	profi_data_conflict_done( llHdl, tries, start );
 
 	return(err);
 }
@@ -491,19 +556,112 @@ possible return values:
 {
 LOCAL_VARIABLES
 	PB_INT16 err;
+	u_int32  tries = 0;
+	u_int32  start = 0;
 
 FUNCTION_BODY
 
-    llHdl->cTick_pb_set_get_data = ACT_TICK;
-
     while ((err = cmi_get_data_descr(llHdl,data_id,offset,data_size,data_ptr))
 		   == E_IF_SERVICE_CONSTR_CONFLICT) {
-		
-        if ( (int32) (ACT_TICK - llHdl->cTick_pb_set_get_data) >= ((int32) (5 * TICK_RATE)) ) {
+		/* retry while semaphore busy */
+		if ( tries == 0 )
+			start = ACT_TICK;
+        if ( profi_data_conflict( llHdl, &tries, start ) ) {
            return(E_IF_SERVICE_CONSTR_CONFLICT);
 	    }
     }
+	profi_data_conflict_done( llHdl, tries, start );
 
 	return(err);
 }
 
+
+FUNCTION LOCAL PB_BOOL profi_data_conflict
+        (
+          LL_HANDLE   *llHdl,
+          INOUT u_int32 *triesP,    /* nbr of retries so far */
+          IN  u_int32  start        /* tick of first conflict */
+        ) /* nodoc */
+
+/*-----------------------------------------------------------------------------
+FUNCTIONAL_DESCRIPTION
+
+This function is called each time the data descriptor semaphore is held by
+the firmware. The first conflictSpin retries are done immediately, the next
+conflictSpin retries yield the CPU, further retries delay one tick each.
+
+possible return values:
+- FALSE  -> retry
+- TRUE   -> timeout, give up
+
+-----------------------------------------------------------------------------*/
+{
+LOCAL_VARIABLES
+	u_int32 timeout;
+
+FUNCTION_BODY
+	if ( *triesP == 0 )
+		llHdl->conflictCnt++;
+	(*triesP)++;
+
+	/* timeout in ticks, at least one tick */
+	timeout = (llHdl->conflictTimeout * TICK_RATE + 999) / 1000;
+	if ( timeout == 0 )
+		timeout = 1;
+
+	if ( (ACT_TICK - start) >= timeout ) {
+		llHdl->conflictTimeouts++;
+		profi_data_conflict_done( llHdl, *triesP, start );
+		DBGWRT_ERR((DBH, "*** profi_data_conflict: timeout after %d retries\n", *triesP));
+		return(TRUE);
+	}
+
+	/* back off */
+	if ( *triesP > 2 * llHdl->conflictSpin )
+		taskDelay( 1 );
+	else if ( *triesP > llHdl->conflictSpin )
+		taskDelay( 0 );
+
+	return(FALSE);
+}
+
+
+FUNCTION LOCAL VOID profi_data_conflict_done
+        (
+          LL_HANDLE   *llHdl,
+          IN  u_int32  tries,       /* nbr of retries */
+          IN  u_int32  start        /* tick of first conflict */
+        ) /* nodoc */
+
+/*-----------------------------------------------------------------------------
+FUNCTIONAL_DESCRIPTION
+
+This function updates the wait time statistics after a data access which
+was delayed by a conflict.
+
+-----------------------------------------------------------------------------*/
+{
+LOCAL_VARIABLES
+	u_int32 ms;
+
+FUNCTION_BODY
+	if ( tries == 0 )
+		return;
+
+	ms = ((ACT_TICK - start) * 1000) / TICK_RATE;
+
+	if ( ms > llHdl->conflictMaxWait )
+		llHdl->conflictMaxWait = ms;
+
+	if ( ms < 1 )
+		llHdl->conflictHist[0]++;
+	else if ( ms < 10 )
+		llHdl->conflictHist[1]++;
+	else if ( ms < 100 )
+		llHdl->conflictHist[2]++;
+	else if ( ms < 1000 )
+		llHdl->conflictHist[3]++;
+	else
+		llHdl->conflictHist[4]++;
+}
+
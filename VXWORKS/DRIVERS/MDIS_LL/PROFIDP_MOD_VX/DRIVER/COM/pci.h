@@ -43,6 +43,11 @@ FUNCTION GLOBAL PB_INT16 CALL_CONV profi_init
           */
         );
         
+FUNCTION GLOBAL PB_INT16 CALL_CONV profi_attach
+        (
+			LL_HANDLE  *llHdl
+        );
+
 FUNCTION GLOBAL PB_INT16 CALL_CONV profi_end(VOID);
 
 
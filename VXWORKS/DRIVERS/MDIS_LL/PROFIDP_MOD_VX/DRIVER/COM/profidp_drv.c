@@ -22,6 +22,9 @@
  *
  *     Required: OSS, DESC, DBG, ID libraries
  *     Switches: _ONE_NAMESPACE_PER_DRIVER_
+ *               PROFIDP_A24        request the A24 address space for
+ *                                  DPRAM_DIRECT (carrier must map A24)
+ *               PROFIDP_TIMESTAMP  time startup phases with sysTimestamp()
  *
  *-------------------------------[ History ]---------------------------------
  *
@@ -136,6 +139,11 @@ static const char RCSid[]="$Id: profidp_drv.c,v 1.1 2014/11/05 10:51:26 AGromann
 #	include <string.h>
 #	include	<rebootLib.h>
 # endif
+# ifdef	PROFIDP_TIMESTAMP
+#	include	<tickLib.h>
+#	include	<sysLib.h>
+#	include	<drv/timer/timestampDev.h>
+# endif
 
 /*-----------------------------------------+
 |  DEFINES                                 |
@@ -143,13 +151,25 @@ static const char RCSid[]="$Id: profidp_drv.c,v 1.1 2014/11/05 10:51:26 AGromann
 /* general */
 #define CH_NUMBER			(DP_MAX_NUMBER_SLAVES + 1) /* number of device channels */
 #define USE_IRQ				TRUE		/* FALSE interrupt required  */
+#ifdef PROFIDP_A24
+#define ADDRSPACE_COUNT		2			/* nr of required address spaces */
+#else
 #define ADDRSPACE_COUNT		1			/* nr of required address spaces */
-#define ADDRSPACE_SIZE		256			/* size of address space */
+#endif
+#define ADDRSPACE_SIZE		256			/* size of address space (A08) */
+#define ADDRSPACE_SIZE_A24	0x100000	/* size of address space (A24, DPRAM) */
 #define MOD_ID_MAGIC		0x5346      /* ID PROM magic word */
 #define MOD_ID_SIZE			128			/* ID PROM size [bytes] */
 #define MOD_ID				57			/* ID PROM module ID */
 #define M57_ARRAY_OFFS      4           /* offset for firmware array */
 
+/* resolution of dp_time_us() (us) */
+#ifdef PROFIDP_TIMESTAMP
+#define DP_TIME_RES		(sysTimestampFreq() >= 1000000 ? 1 : 1000000 / sysTimestampFreq())
+#else
+#define DP_TIME_RES		(1000000 / TICK_RATE)
+#endif
+
 /* check if byte ordering is set */
 #if defined(_BIG_ENDIAN_) || defined(_LITTLE_ENDIAN_)
 #else
@@ -196,44 +216,84 @@ static void load_segment ( MACCESS base, u_int32 seg_offs,
 static int verify_fw_segment ( MACCESS base, u_int32 seg_offs,
                          u_int32 offset, u_int32 length, LL_HANDLE* llHdl);
 
-static T_DP_BUS_PARA_SET* dp_bincfg_get_buspar(LL_HANDLE* llHdl, u_int8* data_ptr,
-                                        u_int32 data_size );
+static u_int32 crc_fw_segment ( MACCESS base, u_int32 seg_offs, u_int32 offset,
+                         u_int32 length, LL_HANDLE* llHdl, u_int32 crc, int readback );
+static u_int32 dp_crc32 ( u_int32 crc, const u_int8 *p, u_int32 len );
+static u_int32 dp_desc_crc ( LL_HANDLE* llHdl );
+static DP_HOT_STATE* dp_hot_find ( MACCESS ma );
+static int32 dp_hot_attach ( LL_HANDLE* llHdl, DP_HOT_STATE* hs );
 
-static T_DP_SLAVE_PARA_SET* dp_bincfg_get_slavepar(LL_HANDLE* llHdl, u_int8* data_ptr,
-                                             u_int32 data_size, u_int8 slave_address );
+static void fw_open ( FW_STREAM *fs, u_int32 seg_offs, LL_HANDLE* llHdl );
 
-static u_int32 _skip_align(LL_HANDLE* llHdl, u_int8* data_ptr );
+static u_int32 fw_read ( FW_STREAM *fs, u_int16 *buf, u_int32 num );
 
-static int16 req_con( LL_HANDLE* llHdl, u_int8 layer, u_int8 service,
-                    u_int8* data_ptr, u_int16* status_ptr );
+static int32 dp_bincfg_index(LL_HANDLE* llHdl, u_int8* data_ptr, u_int32 data_size,
+                             CFG_SLAVE* idx );
+
+static int32 dp_bincfg_slave(LL_HANDLE* llHdl, u_int8* data_ptr, u_int32 data_size,
+                             u_int8 slave_address, CFG_SLAVE* cs );
 
-static u_int8* get_offs (LL_HANDLE* llHdl, u_int8* address, u_int8* sl_addr,
-                      u_int8* i_offs, u_int8* o_offs, u_int16* sl_para_len);
+static int32 dp_pcfg_check(LL_HANDLE* llHdl, u_int8* data_ptr, u_int32 data_size,
+                           CFG_SLAVE* idx );
+static void dp_diag_alloc( LL_HANDLE* llHdl );
+static void dp_diag_refetch( LL_HANDLE* llHdl );
+static void dp_diag_update( LL_HANDLE* llHdl, u_int8 addr, u_int8* data, u_int32 len );
+static void dp_diag_hist_add( LL_HANDLE* llHdl, u_int8 addr, u_int8* data, u_int32 len );
+
+static int16 req_con( LL_HANDLE* llHdl, u_int8 layer, u_int8 service,
+                    u_int8* data_ptr, u_int16* status_ptr, u_int8* con_ptr );
+static PEND_REQ* PROFIDP_pendReqAlloc( LL_HANDLE* llHdl, u_int8 layer, u_int8 service,
+									   u_int16 comm_ref );
+static void PROFIDP_pendReqFree( LL_HANDLE* llHdl, PEND_REQ* req );
+static int PROFIDP_pendReqComplete( LL_HANDLE* llHdl, T_PROFI_SERVICE_DESCR* c_sdb,
+									u_int8* data, u_int16 len );
+static int32 PROFIDP_asyncSubmit( LL_HANDLE* llHdl, M_SG_BLOCK* blk );
+static int32 PROFIDP_asyncReap( LL_HANDLE* llHdl, M_SG_BLOCK* blk );
+static void PROFIDP_asyncDone( LL_HANDLE* llHdl, PEND_REQ* req, int32 error );
+static void PROFIDP_asyncExpire( LL_HANDLE* llHdl );
 
 static int16 dp_setstate(LL_HANDLE* llHdl, u_int8 state, u_int16* con_status );
 
+static int16 dp_act_slave(LL_HANDLE* llHdl, u_int8 slave, u_int8 activate, u_int16* con_status );
+
+static int32 PROFIDP_slaveParam( LL_HANDLE* llHdl, M_SG_BLOCK* blk );
+
 static int16 PROFIDP_data_transfer (LL_HANDLE* llHdl, M_SG_BLOCK* blk);
 
 static int16 PROFIDP_get_slave_diag (LL_HANDLE* llHdl, M_SG_BLOCK* blk);
 
-static int8 waitForService_clear ( LL_HANDLE* llHdl );
+static int32 PROFIDP_ch_list (LL_HANDLE* llHdl, M_SG_BLOCK* blk, u_int8 write);
 
-static void PROFIDP_inConIndBuffer ( LL_HANDLE* llHdl, T_PROFI_SERVICE_DESCR* c_sdb, u_int8* Buffer );
+static int PROFIDP_inConIndBuffer ( LL_HANDLE* llHdl, T_PROFI_SERVICE_DESCR* c_sdb, u_int8* Buffer, u_int16 len );
+static void PROFIDP_dropConInd ( LL_HANDLE* llHdl );
 
 static int16 PROFIDP_outConIndBuffer ( LL_HANDLE* llHdl, M_SG_BLOCK* blk );
+static u_int32 PROFIDP_readConInd ( LL_HANDLE* llHdl, u_int8* dst, u_int32 size, u_int8 withHdr );
+static void PROFIDP_conIndFlushHeld ( LL_HANDLE* llHdl );
+static int32 PROFIDP_outConIndMulti ( LL_HANDLE* llHdl, M_SG_BLOCK* blk );
 
 static int16 PROFIDP_copy_buspar (u_int16 length, u_int8 *sourceP, u_int8 *destinationP);
 
 static int16 profi_snd_req_res_usr(
 	LL_HANDLE     		  *llHdl,
 	T_PROFI_SERVICE_DESCR FAR *sdb_ptr,
-	VOID                  FAR *data_ptr,
-	PB_BOOL               driverIntCon
+	VOID                  FAR *data_ptr
 	);
 static int32 GetChannelDir( LL_HANDLE *llHdl, int32 ch);
 static void PROFIDP_sendDiagReqIrq(LL_HANDLE *llHdl);
 static int32 PROFIDP_aliveCheck(LL_HANDLE *llHdl);
 static int PROFIDP_IsrTask(LL_HANDLE *llHdl);
+static int PROFIDP_SnapTask(LL_HANDLE *llHdl);
+static int32 PROFIDP_snapRead(LL_HANDLE *llHdl, u_int32 offs, u_int16 *sizeP, u_int8 *buf);
+static int32 PROFIDP_snapAlloc(LL_HANDLE *llHdl);
+static void PROFIDP_chgDetect(LL_HANDLE *llHdl, u_int8 *oldBuf, u_int8 *newBuf);
+static int PROFIDP_FlushTask(LL_HANDLE *llHdl);
+static int PROFIDP_AliveTask(LL_HANDLE *llHdl);
+static int32 PROFIDP_aliveProbe(LL_HANDLE *llHdl);
+static int32 PROFIDP_liveList(LL_HANDLE *llHdl, PROFIDP_LIVE_LIST *ll);
+static int PROFIDP_SubmitTask(LL_HANDLE *llHdl);
+static void PROFIDP_outShadowWrite(LL_HANDLE *llHdl, u_int32 offs, u_int32 len, u_int8 *buf);
+static int32 PROFIDP_flushOutputs(LL_HANDLE *llHdl);
 
 /**************************** PROFIDP_GetEntry *********************************
  *
@@ -286,14 +346,34 @@ PROFIDP_rebootHook (int const startType)
 }
 # endif
 
+/* 4 bit CRC32 table for crc_fw_segment/dp_crc32 */
+static const u_int32 dp_crcTab[16] = {
+	0x00000000, 0x1db71064, 0x3b6e20c8, 0x26d930ac,
+	0x76dc4190, 0x6b6b51f4, 0x4db26158, 0x5005713c,
+	0xedb88320, 0xf00f9344, 0xd6d6a3e8, 0xcb61b38c,
+	0x9b64c2b0, 0x86d3d2d4, 0xa00ae278, 0xbdbdf21c };
+
+/* modules left running by PROFIDP_Exit (HOT_REATTACH) */
+static DP_HOT_STATE PROFIDP_hotState[DP_HOT_MAX_MOD];
+
 enum PROFIDP_fini_action {
 	PROFIDP_fini_exit,
+	PROFIDP_fini_alive_task_failed,
+	PROFIDP_fini_sq_task_failed,
+	PROFIDP_fini_sqSemP_failed,
+	PROFIDP_fini_cqSemP_failed,
+	PROFIDP_fini_chgSemP_failed,
+	PROFIDP_fini_flush_task_failed,
+	PROFIDP_fini_flushSemP_failed,
+	PROFIDP_fini_outShadowSemP_failed,
+	PROFIDP_fini_snap_task_failed,
+	PROFIDP_fini_snapSemP_failed,
 	PROFIDP_fini_ISR_task_failed,
 	PROFIDP_fini_windowPointerSemId_failed,
 	PROFIDP_fini_isrTaskSemP_failed,
-	PROFIDP_fini_fwAliveCheckSemP_failed,
+	PROFIDP_fini_aliveSemP_failed,
 	PROFIDP_fini_con_buf_semP_failed,
-	PROFIDP_fini_req_con_0f_semP_failed,
+	PROFIDP_fini_pendReq_failed,
 	PROFIDP_fini_req_con_f0_semP_failed,
 	PROFIDP_fini_con_ind_buf_alloc_success,
 	PROFIDP_fini_con_ind_buf_alloc_failed,
@@ -322,17 +402,36 @@ static int32 PROFIDP_fini (
 )
 {
     LL_HANDLE *llHdl = *llHdlP;
+	DP_HOT_STATE *hs;
 
     DBGWRT_1((DBH, "LL - PROFIDP_fini\n"));
 
 	switch (action) {
 	case PROFIDP_fini_exit:
 
+		/* delete alive task before the firmware is stopped */
+		if ( taskDelete( llHdl->aliveTaskId ) != 0 ) {
+			DBGWRT_ERR((DBH," *** PROFIDP_fini: Error deleting alive task\n"));
+		}
+
 		/*------------------------------+
 		|  de-init hardware             |
 		+------------------------------*/
 
-		M57_RESET_SEQUENCE (llHdl);
+		if ( llHdl->hotReattach && llHdl->cfgHash &&
+			 (hs = dp_hot_find( (MACCESS) 0 )) != NULL ) {
+			/* leave the firmware running for the next PROFIDP_Init */
+			M57_IRQ_DISABLE( llHdl->ma );
+			hs->ma         = llHdl->ma;
+			hs->fwCrc      = llHdl->fwCrc;
+			hs->cfgHash    = llHdl->cfgHash;
+			hs->descCrc    = llHdl->descCrc;
+			hs->stackState = llHdl->stackState;
+			DBGWRT_1((DBH, "LL - PROFIDP_fini: firmware left running, "
+					  "cfg hash %08x\n", llHdl->cfgHash));
+		}
+		else
+			M57_RESET_SEQUENCE (llHdl);
 
 # ifdef	PROFIDP_reboothook
 		{
@@ -368,6 +467,75 @@ static int32 PROFIDP_fini (
 		}
 reboothook_found_done:
 # endif
+	case PROFIDP_fini_alive_task_failed:
+
+		/* delete submission task */
+		if ( taskDelete( llHdl->sqTaskId ) != 0 ) {
+			DBGWRT_ERR((DBH," *** PROFIDP_fini: Error deleting submission task\n"));
+		}
+	case PROFIDP_fini_sq_task_failed:
+
+		/* remove semaphore for submission queue */
+		if ((OSS_SemRemove( llHdl->osHdl, &llHdl->sqSemP )) != 0) {
+			DBGWRT_ERR((DBH," *** PROFIDP_fini: "
+					"Error removing submission queue semaphore\n"));
+		}
+	case PROFIDP_fini_sqSemP_failed:
+
+		/* remove semaphore for completion queue */
+		if ((OSS_SemRemove( llHdl->osHdl, &llHdl->cqSemP )) != 0) {
+			DBGWRT_ERR((DBH," *** PROFIDP_fini: "
+					"Error removing completion queue semaphore\n"));
+		}
+	case PROFIDP_fini_cqSemP_failed:
+
+		/* remove semaphore for input change bitmap */
+		if ((OSS_SemRemove( llHdl->osHdl, &llHdl->chgSemP )) != 0) {
+			DBGWRT_ERR((DBH," *** PROFIDP_fini: "
+					"Error removing change bitmap semaphore\n"));
+		}
+	case PROFIDP_fini_chgSemP_failed:
+
+		/* delete flush task */
+		if ( taskDelete( llHdl->flushTaskId ) != 0 ) {
+			DBGWRT_ERR((DBH," *** PROFIDP_fini: Error deleting flush task\n"));
+		}
+
+		/* free output shadow */
+		if ( llHdl->outShadow )
+			OSS_MemFree(llHdl->osHdl, llHdl->outShadow, llHdl->outShadowMemSize);
+	case PROFIDP_fini_flush_task_failed:
+
+		/* remove semaphore for flush task */
+		if ((OSS_SemRemove( llHdl->osHdl, &llHdl->flushSemP )) != 0) {
+			DBGWRT_ERR((DBH," *** PROFIDP_fini: "
+					"Error removing flush semaphore\n"));
+		}
+	case PROFIDP_fini_flushSemP_failed:
+
+		/* remove semaphore for output shadow */
+		if ((OSS_SemRemove( llHdl->osHdl, &llHdl->outShadowSemP )) != 0) {
+			DBGWRT_ERR((DBH," *** PROFIDP_fini: "
+					"Error removing output shadow semaphore\n"));
+		}
+	case PROFIDP_fini_outShadowSemP_failed:
+
+		/* delete snapshot task */
+		if ( taskDelete( llHdl->snapTaskId ) != 0 ) {
+			DBGWRT_ERR((DBH," *** PROFIDP_fini: Error deleting snapshot task\n"));
+		}
+
+		/* free input snapshot buffer */
+		if ( llHdl->snapBuf )
+			OSS_MemFree(llHdl->osHdl, llHdl->snapBuf, llHdl->snapMemSize);
+	case PROFIDP_fini_snap_task_failed:
+
+		/* remove semaphore for snapshot task */
+		if ((OSS_SemRemove( llHdl->osHdl, &llHdl->snapSemP )) != 0) {
+			DBGWRT_ERR((DBH," *** PROFIDP_fini: "
+					"Error removing snapshot semaphore\n"));
+		}
+	case PROFIDP_fini_snapSemP_failed:
 
 		/* delete ISR task */
 		if ( taskDelete( llHdl->isrTaskId ) != 0 ) {
@@ -393,12 +561,12 @@ reboothook_found_done:
 		}
 	case PROFIDP_fini_isrTaskSemP_failed:
 
-		/* remove semaphore for alive check */
-		if ((OSS_SemRemove( llHdl->osHdl, &llHdl->fwAliveCheckSemP )) != 0) {
+		/* remove semaphore for alive task */
+		if ((OSS_SemRemove( llHdl->osHdl, &llHdl->aliveSemP )) != 0) {
 			DBGWRT_ERR((DBH," *** PROFIDP_fini: "
 					"Error removing alive check semaphore\n"));
 		}
-	case PROFIDP_fini_fwAliveCheckSemP_failed:
+	case PROFIDP_fini_aliveSemP_failed:
 
 		/* remove semaphore for CON/IND buffer */
 		if ((OSS_SemRemove( llHdl->osHdl, &llHdl->con_buf_semP )) != 0) {
@@ -407,12 +575,25 @@ reboothook_found_done:
 		}
 	case PROFIDP_fini_con_buf_semP_failed:
 
-		/* remove semaphore for REQ/CON 0f */
-		if ((OSS_SemRemove( llHdl->osHdl, &llHdl->req_con_0f_semP )) != 0) {
-			DBGWRT_ERR((DBH," *** PROFIDP_fini: "
-					"Error removing REQ/CON semaphore\n"));
+	case PROFIDP_fini_pendReq_failed:
+
+		/* remove semaphores for pending requests */
+		{
+			int n;
+
+			for ( n = 0; n < DP_MAX_PEND_REQ; n++ ) {
+				if ( llHdl->pendReq[n].semP &&
+					 (OSS_SemRemove( llHdl->osHdl, &llHdl->pendReq[n].semP )) != 0) {
+					DBGWRT_ERR((DBH," *** PROFIDP_fini: "
+							"Error removing pending request semaphore\n"));
+				}
+			}
+			if ( llHdl->pendReqFreeSemP &&
+				 (OSS_SemRemove( llHdl->osHdl, &llHdl->pendReqFreeSemP )) != 0) {
+				DBGWRT_ERR((DBH," *** PROFIDP_fini: "
+						"Error removing pending request semaphore\n"));
+			}
 		}
-	case PROFIDP_fini_req_con_0f_semP_failed:
 
 		/* remove semaphore for REQ/CON f0 */
 		if ((OSS_SemRemove( llHdl->osHdl, &llHdl->req_con_f0_semP )) != 0) {
@@ -427,6 +608,12 @@ reboothook_found_done:
 		|  free memory                  |
 		+------------------------------*/
 
+		/* free slave diag store and history */
+		if ( llHdl->diagStore )
+			OSS_MemFree(llHdl->osHdl, llHdl->diagStore, llHdl->diagMemSize);
+		if ( llHdl->diagHist )
+			OSS_MemFree(llHdl->osHdl, llHdl->diagHist, llHdl->diagHistMemSize);
+
 		/* free CON/IND Buffer */
 		OSS_MemFree(llHdl->osHdl, llHdl->con_ind_buf,
 				llHdl->con_ind_memSize);
@@ -507,10 +694,36 @@ reboothook_found_done:
  *                number of elements in CON/IND buf:
  *                CON_IND_BUF_EL          127              0..max
  *
+ *                access DPRAM directly via A24 address space
+ *                (0 = use A08 window):
+ *                DPRAM_DIRECT            PB_FALSE         PB_TRUE, PB_FALSE
+ *
+ *                period (ms) of host input snapshot
+ *                (0 = reads access the DPRAM):
+ *                INPUT_SNAPSHOT_PERIOD   0                0..max
+ *
+ *                period (ms) to flush host output shadow
+ *                (0 = writes access the DPRAM):
+ *                OUTPUT_FLUSH_PERIOD     0                0..max
+ *
+ *                period (ms) of firmware alive check
+ *                (0 = no check):
+ *                ALIVE_CHECK_PERIOD      2000             0..max
+ *
+ *                max wait (ms) for data descriptor semaphore:
+ *                DATA_CONFLICT_TIMEOUT   5000             1..max
+ *
+ *                retries on semaphore conflict before backing off:
+ *                DATA_CONFLICT_SPIN      16               0..max
+ *
+ *                nbr of records of slave diag history
+ *                (0 = no history):
+ *                DIAG_HISTORY            64               0..max
+ *
  *---------------------------------------------------------------------------
  *  Input......:  descSpec   pointer to descriptor data
  *                osHdl      oss handle
- *                ma         hardware access handle
+ *                ma         hardware access handles (A08, A24)
  *                devSemHdl  device semaphore handle
  *                irqHdl     irq handle
  *  Output.....:  llHdlP     pointer to low-level driver handle
@@ -530,7 +743,7 @@ static int32 PROFIDP_Init(
     u_int32 gotsize;
     int32 error;
     u_int32 value;
-	u_int32         elements_con_ind;
+	u_int32         elements_con_ind, size;
 	u_int32         isr_task_prio;
 	int16           i;
 	u_int32         lowSlAddr;
@@ -538,7 +751,10 @@ static int32 PROFIDP_Init(
 	m57_download*  down_p;
 	m57_segm*      seg_p;
 	int            segcnt;
+	int            fwLoaded;
 	const u_int8*  dummy;
+	u_int32        t;
+	DP_HOT_STATE*  hs;
 
     /*------------------------------+
     |  prepare the handle           |
@@ -558,7 +774,12 @@ static int32 PROFIDP_Init(
     llHdl->memAlloc   = gotsize;
     llHdl->osHdl      = osHdl;
     llHdl->irqHdl     = irqHdl;
-    llHdl->ma		  = *ma;
+    llHdl->devSemP    = devSemHdl;
+    llHdl->ma		  = ma[0];
+#ifdef PROFIDP_A24
+    llHdl->maDpram    = ma[1];
+#endif
+    llHdl->hw_wptr    = DP_WPTR_INVALID;	/* window pointer unknown */
 
 	/* initialize pointer for CON/IND Buffer */
 	llHdl->con_ind_buf = 0;
@@ -711,6 +932,65 @@ static int32 PROFIDP_Init(
     DBGWRT_2((DBH, "LL - PROFIDP_Init: MASTER_CLASS_2 = %08x\n",
 			llHdl->masterClass2));
 
+    /* direct DPRAM access via A24 address space */
+    if ((error = DESC_GetUInt32(llHdl->descHdl, DP_DPRAM_DIRECT,
+					&llHdl->dpramDirect, "DPRAM_DIRECT")) &&
+			error != ERR_DESC_KEY_NOTFOUND)
+		return (PROFIDP_fini (&llHdl, error,
+				PROFIDP_fini_DESC_access_failed));
+
+    DBGWRT_2((DBH, "LL - PROFIDP_Init: DPRAM_DIRECT = %08x\n",
+			llHdl->dpramDirect));
+
+#ifndef PROFIDP_A24
+	if (llHdl->dpramDirect) {
+		DBGWRT_ERR((DBH, " *** PROFIDP_Init: DPRAM_DIRECT needs driver "
+					"built with PROFIDP_A24\n"));
+		return (PROFIDP_fini (&llHdl, ERR_LL_DESC_PARAM,
+				PROFIDP_fini_DESC_access_failed));
+	}
+#endif
+
+    /* verification of loaded firmware */
+    if ((error = DESC_GetUInt32(llHdl->descHdl, DP_FW_VERIFY,
+					&llHdl->fwVerify, "FW_VERIFY")) &&
+			error != ERR_DESC_KEY_NOTFOUND)
+		return (PROFIDP_fini (&llHdl, error,
+				PROFIDP_fini_DESC_access_failed));
+
+    DBGWRT_2((DBH, "LL - PROFIDP_Init: FW_VERIFY = %d\n",
+			llHdl->fwVerify));
+
+    /* skip loading of identical firmware */
+    if ((error = DESC_GetUInt32(llHdl->descHdl, DP_FW_SKIP_LOADED,
+					&llHdl->fwSkipLoaded, "FW_SKIP_LOADED")) &&
+			error != ERR_DESC_KEY_NOTFOUND)
+		return (PROFIDP_fini (&llHdl, error,
+				PROFIDP_fini_DESC_access_failed));
+
+    DBGWRT_2((DBH, "LL - PROFIDP_Init: FW_SKIP_LOADED = %d\n",
+			llHdl->fwSkipLoaded));
+
+    /* keep firmware running on exit and re-attach to it */
+    if ((error = DESC_GetUInt32(llHdl->descHdl, DP_HOT_REATTACH,
+					&llHdl->hotReattach, "HOT_REATTACH")) &&
+			error != ERR_DESC_KEY_NOTFOUND)
+		return (PROFIDP_fini (&llHdl, error,
+				PROFIDP_fini_DESC_access_failed));
+
+    DBGWRT_2((DBH, "LL - PROFIDP_Init: HOT_REATTACH = %d\n",
+			llHdl->hotReattach));
+
+    /* hash of the configuration to re-attach to */
+    if ((error = DESC_GetUInt32(llHdl->descHdl, DP_CONFIG_HASH,
+					&llHdl->cfgHashDesc, "CONFIG_HASH")) &&
+			error != ERR_DESC_KEY_NOTFOUND)
+		return (PROFIDP_fini (&llHdl, error,
+				PROFIDP_fini_DESC_access_failed));
+
+    DBGWRT_2((DBH, "LL - PROFIDP_Init: CONFIG_HASH = %08x\n",
+			llHdl->cfgHashDesc));
+
     /* Priority of ISR-Task */
     if ((error = DESC_GetUInt32(llHdl->descHdl, DP_ISR_TASK_PRIO,
 					&isr_task_prio, "ISR_TASK_PRIO")) &&
@@ -719,13 +999,64 @@ static int32 PROFIDP_Init(
 				PROFIDP_fini_DESC_access_failed));
     DBGWRT_1((DBH, "LL - PROFIDP_Init: ISR_TASK_PRIO = %08x\n", isr_task_prio));
 
+    /* period of input snapshot */
+    if ((error = DESC_GetUInt32(llHdl->descHdl, DP_INPUT_SNAPSHOT_PERIOD,
+					&llHdl->snapPeriod, "INPUT_SNAPSHOT_PERIOD")) &&
+			error != ERR_DESC_KEY_NOTFOUND)
+		return (PROFIDP_fini (&llHdl, error,
+				PROFIDP_fini_DESC_access_failed));
+    DBGWRT_2((DBH, "LL - PROFIDP_Init: INPUT_SNAPSHOT_PERIOD = %d\n",
+			llHdl->snapPeriod));
+
+    /* flush period of output shadow */
+    if ((error = DESC_GetUInt32(llHdl->descHdl, DP_OUTPUT_FLUSH_PERIOD,
+					&llHdl->flushPeriod, "OUTPUT_FLUSH_PERIOD")) &&
+			error != ERR_DESC_KEY_NOTFOUND)
+		return (PROFIDP_fini (&llHdl, error,
+				PROFIDP_fini_DESC_access_failed));
+    DBGWRT_2((DBH, "LL - PROFIDP_Init: OUTPUT_FLUSH_PERIOD = %d\n",
+			llHdl->flushPeriod));
+
+    /* period of firmware alive check */
+    if ((error = DESC_GetUInt32(llHdl->descHdl, DP_ALIVE_CHECK_PERIOD,
+					&llHdl->alivePeriod, "ALIVE_CHECK_PERIOD")) &&
+			error != ERR_DESC_KEY_NOTFOUND)
+		return (PROFIDP_fini (&llHdl, error,
+				PROFIDP_fini_DESC_access_failed));
+    DBGWRT_2((DBH, "LL - PROFIDP_Init: ALIVE_CHECK_PERIOD = %d\n",
+			llHdl->alivePeriod));
+
+    /* max wait for data descriptor semaphore */
+    if ((error = DESC_GetUInt32(llHdl->descHdl, DP_DATA_CONFLICT_TIMEOUT,
+					&llHdl->conflictTimeout, "DATA_CONFLICT_TIMEOUT")) &&
+			error != ERR_DESC_KEY_NOTFOUND)
+		return (PROFIDP_fini (&llHdl, error,
+				PROFIDP_fini_DESC_access_failed));
+    DBGWRT_2((DBH, "LL - PROFIDP_Init: DATA_CONFLICT_TIMEOUT = %d\n",
+			llHdl->conflictTimeout));
+
+    /* retries before backing off */
+    if ((error = DESC_GetUInt32(llHdl->descHdl, DP_DATA_CONFLICT_SPIN,
+					&llHdl->conflictSpin, "DATA_CONFLICT_SPIN")) &&
+			error != ERR_DESC_KEY_NOTFOUND)
+		return (PROFIDP_fini (&llHdl, error,
+				PROFIDP_fini_DESC_access_failed));
+    DBGWRT_2((DBH, "LL - PROFIDP_Init: DATA_CONFLICT_SPIN = %d\n",
+			llHdl->conflictSpin));
+
     /* size of CON/IND Buffer */
     if ((error = DESC_GetUInt32(llHdl->descHdl, DP_CON_IND_BUF_EL,
 					&elements_con_ind, "CON_IND_BUF_EL")) &&
 			error != ERR_DESC_KEY_NOTFOUND)
 		return (PROFIDP_fini (&llHdl, error,
 				PROFIDP_fini_DESC_access_failed));
-    llHdl->con_ind_buf_size = elements_con_ind * CON_IND_BUF_ELEMENT_SIZE;
+    /* records only use the real service data length, one extra record
+       covers the unused rest at the end of the buffer. Power of two, so
+       the free-running head/tail modulo size stay valid when they wrap */
+    size = ((elements_con_ind * CON_IND_BUF_ELEMENT_SIZE + 3) & ~3) +
+		   CON_IND_REC_SIZE( DP_MAX_TELEGRAM_LEN );
+    for( llHdl->con_ind_buf_size = 4; llHdl->con_ind_buf_size < size; )
+		llHdl->con_ind_buf_size <<= 1;
     DBGWRT_2((DBH, "LL - PROFIDP_Init: CON_IND_BUF_SIZE = %08x\n",
 			llHdl->con_ind_buf_size));
 
@@ -743,8 +1074,33 @@ static int32 PROFIDP_Init(
 
 	llHdl->con_ind_memSize = gotsize;
 
-	llHdl->con_ind_buf_outP = llHdl->con_ind_buf;
-	llHdl->con_ind_buf_inP  = llHdl->con_ind_buf;
+	llHdl->con_ind_head = 0;
+	llHdl->con_ind_tail = 0;
+
+    /* CON/IND buffer overflow policy */
+    if ((error = DESC_GetUInt32(llHdl->descHdl, DP_CON_IND_POLICY,
+					&llHdl->con_ind_policy, "CON_IND_POLICY")) &&
+			error != ERR_DESC_KEY_NOTFOUND)
+		return (PROFIDP_fini (&llHdl, error,
+				PROFIDP_fini_con_ind_buf_alloc_success));
+    DBGWRT_2((DBH, "LL - PROFIDP_Init: CON_IND_POLICY = %d\n",
+			llHdl->con_ind_policy));
+
+    /* size of slave diag history */
+    if ((error = DESC_GetUInt32(llHdl->descHdl, DP_DIAG_HISTORY,
+					&llHdl->diagHistNum, "DIAG_HISTORY")) &&
+			error != ERR_DESC_KEY_NOTFOUND)
+		return (PROFIDP_fini (&llHdl, error,
+				PROFIDP_fini_con_ind_buf_alloc_success));
+    DBGWRT_2((DBH, "LL - PROFIDP_Init: DIAG_HISTORY = %d\n",
+			llHdl->diagHistNum));
+
+	if ( llHdl->diagHistNum &&
+		 (llHdl->diagHist = (u_int8*) OSS_MemGet( osHdl,
+			llHdl->diagHistNum * sizeof(PROFIDP_DIAG_REC),
+			&llHdl->diagHistMemSize)) == NULL )
+		return (PROFIDP_fini (&llHdl, ERR_OSS_MEM_ALLOC,
+				PROFIDP_fini_con_ind_buf_alloc_success));
 
     /*------------------------------+
     |  check module ID              |
@@ -782,13 +1138,23 @@ static int32 PROFIDP_Init(
 				PROFIDP_fini_req_con_f0_semP_failed));
 	}
 
-	/* create semaphore for REQ/CON 0f */
-	if ((OSS_SemCreate( llHdl->osHdl, OSS_SEM_BIN, 0,
-			&llHdl->req_con_0f_semP )) != 0) {
+	/* create semaphores for pending requests (REQ/CON 0f) */
+	if ((OSS_SemCreate( llHdl->osHdl, OSS_SEM_COUNT, DP_MAX_PEND_REQ,
+			&llHdl->pendReqFreeSemP )) != 0) {
 		DBGWRT_ERR((DBH," *** PROFIDP_Init: "
-				"Error creating REQ/CON semaphore\n"));
+				"Error creating pending request semaphore\n"));
 		return (PROFIDP_fini (&llHdl, error,
-				PROFIDP_fini_req_con_0f_semP_failed));
+				PROFIDP_fini_pendReq_failed));
+	}
+	for ( i = 0; i < DP_MAX_PEND_REQ; i++ ) {
+		llHdl->pendReq[i].invoke_id = (PB_INT8) (i + 1); /* 0 = sent by ISR-Task */
+		if ((OSS_SemCreate( llHdl->osHdl, OSS_SEM_BIN, 0,
+				&llHdl->pendReq[i].semP )) != 0) {
+			DBGWRT_ERR((DBH," *** PROFIDP_Init: "
+					"Error creating REQ/CON semaphore\n"));
+			return (PROFIDP_fini (&llHdl, error,
+					PROFIDP_fini_pendReq_failed));
+		}
 	}
 
 	/* create semaphore for CON/IND buffer */
@@ -800,13 +1166,13 @@ static int32 PROFIDP_Init(
 				PROFIDP_fini_con_buf_semP_failed));
 	}
 
-	/* create semaphore for cyclic alive check */
-	if ((OSS_SemCreate( llHdl->osHdl, OSS_SEM_BIN, 1,
-			&llHdl->fwAliveCheckSemP )) != 0) {
+	/* create semaphore for waking up alive task */
+	if ((OSS_SemCreate( llHdl->osHdl, OSS_SEM_BIN, 0,
+			&llHdl->aliveSemP )) != 0) {
 		DBGWRT_ERR((DBH," *** PROFIDP_Init: "
 				"Error creating alive check semaphore\n"));
 		return (PROFIDP_fini (&llHdl, error,
-				PROFIDP_fini_fwAliveCheckSemP_failed));
+				PROFIDP_fini_aliveSemP_failed));
 	}
 
 	/* create semaphore for triggering ISR-Task */
@@ -841,6 +1207,125 @@ static int32 PROFIDP_Init(
 		return (PROFIDP_fini (&llHdl, error, PROFIDP_fini_ISR_task_failed));
 	}
 
+    /*------------------------------+
+    |  create snapshot task         |
+    +------------------------------*/
+	/* create semaphore for waking up snapshot task */
+	if ((OSS_SemCreate( llHdl->osHdl, OSS_SEM_BIN, 0,
+			&llHdl->snapSemP )) != 0) {
+		DBGWRT_ERR((DBH," *** PROFIDP_Init: "
+				"Error creating snapshot semaphore\n"));
+		return (PROFIDP_fini (&llHdl, error,
+				PROFIDP_fini_snapSemP_failed));
+	}
+
+	/* runs below the ISR-Task, waits until snapshot enabled */
+	llHdl->snapTaskId = taskSpawn( "tM57Snap",
+								  (int) isr_task_prio + 1,
+			                      0,
+			                      4096,
+			                      (FUNCPTR) PROFIDP_SnapTask,
+			                      (_Vx_usr_arg_t) llHdl,
+								  0, 0, 0, 0, 0, 0, 0, 0, 0 );
+	if( llHdl->snapTaskId == TASK_ID_ERROR ) {
+		error = PROFIDP_ERR_CREATING_TASK;
+		return (PROFIDP_fini (&llHdl, error, PROFIDP_fini_snap_task_failed));
+	}
+
+    /*------------------------------+
+    |  create flush task            |
+    +------------------------------*/
+	/* create semaphore for output shadow */
+	if ((OSS_SemCreate( llHdl->osHdl, OSS_SEM_BIN, 1,
+			&llHdl->outShadowSemP )) != 0) {
+		DBGWRT_ERR((DBH," *** PROFIDP_Init: "
+				"Error creating output shadow semaphore\n"));
+		return (PROFIDP_fini (&llHdl, error,
+				PROFIDP_fini_outShadowSemP_failed));
+	}
+
+	/* create semaphore for waking up flush task */
+	if ((OSS_SemCreate( llHdl->osHdl, OSS_SEM_BIN, 0,
+			&llHdl->flushSemP )) != 0) {
+		DBGWRT_ERR((DBH," *** PROFIDP_Init: "
+				"Error creating flush semaphore\n"));
+		return (PROFIDP_fini (&llHdl, error,
+				PROFIDP_fini_flushSemP_failed));
+	}
+
+	/* runs below the ISR-Task, waits until output shadow enabled */
+	llHdl->flushTaskId = taskSpawn( "tM57Flush",
+								  (int) isr_task_prio + 1,
+			                      0,
+			                      4096,
+			                      (FUNCPTR) PROFIDP_FlushTask,
+			                      (_Vx_usr_arg_t) llHdl,
+								  0, 0, 0, 0, 0, 0, 0, 0, 0 );
+	if( llHdl->flushTaskId == TASK_ID_ERROR ) {
+		error = PROFIDP_ERR_CREATING_TASK;
+		return (PROFIDP_fini (&llHdl, error, PROFIDP_fini_flush_task_failed));
+	}
+
+	/* create semaphore for input change bitmap */
+	if ((OSS_SemCreate( llHdl->osHdl, OSS_SEM_BIN, 1,
+			&llHdl->chgSemP )) != 0) {
+		DBGWRT_ERR((DBH," *** PROFIDP_Init: "
+				"Error creating change bitmap semaphore\n"));
+		return (PROFIDP_fini (&llHdl, error,
+				PROFIDP_fini_chgSemP_failed));
+	}
+
+    /*------------------------------+
+    |  create submission task       |
+    +------------------------------*/
+	/* create semaphore for completion queue */
+	if ((OSS_SemCreate( llHdl->osHdl, OSS_SEM_BIN, 0,
+			&llHdl->cqSemP )) != 0) {
+		DBGWRT_ERR((DBH," *** PROFIDP_Init: "
+				"Error creating completion queue semaphore\n"));
+		return (PROFIDP_fini (&llHdl, error,
+				PROFIDP_fini_cqSemP_failed));
+	}
+
+	/* create semaphore for submission queue */
+	if ((OSS_SemCreate( llHdl->osHdl, OSS_SEM_COUNT, 0,
+			&llHdl->sqSemP )) != 0) {
+		DBGWRT_ERR((DBH," *** PROFIDP_Init: "
+				"Error creating submission queue semaphore\n"));
+		return (PROFIDP_fini (&llHdl, error,
+				PROFIDP_fini_sqSemP_failed));
+	}
+
+	/* runs below the ISR-Task, sends submitted requests */
+	llHdl->sqTaskId = taskSpawn( "tM57Sq",
+								  (int) isr_task_prio + 1,
+			                      0,
+			                      4096,
+			                      (FUNCPTR) PROFIDP_SubmitTask,
+			                      (_Vx_usr_arg_t) llHdl,
+								  0, 0, 0, 0, 0, 0, 0, 0, 0 );
+	if( llHdl->sqTaskId == TASK_ID_ERROR ) {
+		error = PROFIDP_ERR_CREATING_TASK;
+		return (PROFIDP_fini (&llHdl, error, PROFIDP_fini_sq_task_failed));
+	}
+
+    /*------------------------------+
+    |  create alive task            |
+    +------------------------------*/
+	/* lowest priority, waits until firmware configured */
+	llHdl->fwAlive = TRUE;
+	llHdl->aliveTaskId = taskSpawn( "tM57Alive",
+								  (int) isr_task_prio + 2,
+			                      0,
+			                      4096,
+			                      (FUNCPTR) PROFIDP_AliveTask,
+			                      (_Vx_usr_arg_t) llHdl,
+								  0, 0, 0, 0, 0, 0, 0, 0, 0 );
+	if( llHdl->aliveTaskId == TASK_ID_ERROR ) {
+		error = PROFIDP_ERR_CREATING_TASK;
+		return (PROFIDP_fini (&llHdl, error, PROFIDP_fini_alive_task_failed));
+	}
+
     /*------------------------------+
     |  init hardware                |
     +------------------------------*/
@@ -853,7 +1338,9 @@ static int32 PROFIDP_Init(
 	down_p = (m57_download *) dummy;
 	seg_p = &down_p->segment[0];
 
-	if( TWISTLONG_FW(down_p->sync_code) != SYNC_CODE )
+	llHdl->fwPacked = (TWISTLONG_FW(down_p->sync_code) == SYNC_CODE_PACKED);
+
+	if( TWISTLONG_FW(down_p->sync_code) != SYNC_CODE && !llHdl->fwPacked )
 	{
 		DBGWRT_ERR((DBH," *** PROFIDP_Init: Firmware is not valid\n"));
 		DBGWRT_ERR((DBH," *** PROFIDP_Init: Sync_code = %08x\n", down_p->sync_code));
@@ -865,8 +1352,11 @@ static int32 PROFIDP_Init(
 		for(segcnt=0; seg_p->offset; seg_p++, segcnt++)
 		;
 
-	DBGWRT_2((DBH,"LL - PROFIDP_Init: %d segments\n", segcnt ));
+	DBGWRT_2((DBH,"LL - PROFIDP_Init: %d segments%s\n", segcnt,
+			  llHdl->fwPacked ? " (packed)" : "" ));
 	DBGWRT_1((DBH,"\nM57 Base Address = %08p\n", (void*) llHdl->ma ));
+	DBGWRT_1((DBH,"M57 DPRAM Address = %08p (%s)\n", (void*) llHdl->maDpram,
+			  llHdl->dpramDirect ? "direct" : "unused" ));
 
 # ifdef	PROFIDP_reboothook
 	if (1 [&PROFIDP_rebootHook_ll_handle]
@@ -890,32 +1380,88 @@ static int32 PROFIDP_Init(
 	*PROFIDP_rebootHook_next_ll_handle++ = llHdl;
 # endif
 
+	/* init irq flag */
+	llHdl->irqFlag          = 0;   /* flag indicates that irq routine is done at the moment */
+
+	/*--- A24 space decodes A20, as requested by LL_INFO_ADDRSPACE ---*/
+	if( llHdl->dpramDirect ){
+		M57_A24_MODE_A20( llHdl->ma );
+		if( !M57_A24_IS_A20( llHdl->ma ) ){
+			DBGWRT_ERR((DBH," *** PROFIDP_Init: can't set A20 mode, "
+						"using A08 window\n"));
+			llHdl->dpramDirect = 0;
+		}
+	}
+
+	/*---------------------------+
+    |  Check for loaded firmware  |
+    +---------------------------*/
+	t = dp_time_us( llHdl );
+	llHdl->fwCrc = 0xffffffff;
+	/* CRC of the image only needed to compare with the loaded/running one */
+	for( seg_p=down_p->segment; (llHdl->fwSkipLoaded || llHdl->hotReattach) &&
+		 seg_p->offset; seg_p++ )
+		llHdl->fwCrc = crc_fw_segment( llHdl->ma, TWISTLONG_FW (seg_p->offset),
+		     TWISTLONG_FW (seg_p->loadaddr), TWISTLONG_FW (seg_p->length), llHdl,
+		     llHdl->fwCrc, 0 );
+
+	fwLoaded = 0;
+	llHdl->descCrc = dp_desc_crc( llHdl );
+	if( (hs = dp_hot_find( llHdl->ma )) != NULL ){
+		/* firmware left running by PROFIDP_Exit */
+		if( llHdl->hotReattach && dp_hot_attach( llHdl, hs ) == 0 ){
+			fwLoaded = 1;
+			llHdl->reattached = 1;
+			DBGWRT_1((DBH,"LL - PROFIDP_Init: re-attached to running firmware, "
+					  "cfg hash %08x\n", llHdl->cfgHash ));
+		}
+		hs->ma = 0;		/* saved again by PROFIDP_Exit */
+	}
+
 	/*--- reset module ---*/
+	if( !llHdl->reattached ){
+		M57_RESET( llHdl->ma, 1);			/* reset module (keep reset)*/
 
-	M57_RESET( llHdl->ma, 1);			/* reset module (keep reset)*/
+		DBGWRT_2((DBH,"LL - PROFIDP_Init: m57 reseted\n"));
+	}
 
-	DBGWRT_2((DBH,"LL - PROFIDP_Init: m57 reseted\n"));
+	if( llHdl->fwSkipLoaded && !llHdl->reattached ){
+		u_int32 ramCrc = 0xffffffff;
 
-	/* init irq flag */
-	llHdl->irqFlag          = 0;   /* flag indicates that irq routine is done at the moment */
+		/* module RAM keeps the image while the module is held in reset */
+		for( seg_p=down_p->segment; seg_p->offset; seg_p++ )
+			ramCrc = crc_fw_segment( llHdl->ma, TWISTLONG_FW (seg_p->offset),
+			     TWISTLONG_FW (seg_p->loadaddr), TWISTLONG_FW (seg_p->length), llHdl,
+			     ramCrc, 1 );
+
+		fwLoaded = (ramCrc == llHdl->fwCrc);
+		DBGWRT_2((DBH,"LL - PROFIDP_Init: firmware CRC=%08x RAM CRC=%08x%s\n",
+				  llHdl->fwCrc, ramCrc, fwLoaded ? ", skip loading" : "" ));
+	}
+	llHdl->tPhase[DP_T_FW_VALIDATE] = dp_time_us( llHdl ) - t;
 
 	/*----------------+
     |  Load segments  |
     +----------------*/
+	t = dp_time_us( llHdl );
 
-	for( seg_p=down_p->segment; seg_p->offset; seg_p++ ){
+	for( seg_p=down_p->segment; !fwLoaded && seg_p->offset; seg_p++ ){
 		DBGWRT_2((DBH,"LL - PROFIDP_Init: Loading segment loadaddr=$%08x length=%08x\n",
 						  TWISTLONG_FW(seg_p->loadaddr), TWISTLONG_FW(seg_p->length) ));
 
 		load_segment( llHdl->ma, (TWISTLONG_FW (seg_p->offset)),
 		              (TWISTLONG_FW (seg_p->loadaddr)), (TWISTLONG_FW (seg_p->length)), llHdl );
 	}
+	if( !fwLoaded )
+		llHdl->tPhase[DP_T_FW_LOAD] = dp_time_us( llHdl ) - t;
 
 	/*------------------+
     |  Verify segments  |
     +------------------*/
+	t = dp_time_us( llHdl );
 
-	for( seg_p=down_p->segment; seg_p->offset; seg_p++ ){
+	for( seg_p=down_p->segment;
+		 !fwLoaded && llHdl->fwVerify != DP_FW_VERIFY_OFF && seg_p->offset; seg_p++ ){
 		DBGWRT_2((DBH,"LL - PROFIDP_Init: Verify segment loadaddr=$%08x length=%08x\n",
 						  seg_p->loadaddr, seg_p->length ));
 
@@ -926,6 +1472,8 @@ static int32 PROFIDP_Init(
 			return (PROFIDP_fini (&llHdl, error, PROFIDP_fini_exit));
 		 }
 	}
+	if( !fwLoaded && llHdl->fwVerify != DP_FW_VERIFY_OFF )
+		llHdl->tPhase[DP_T_FW_VERIFY] = dp_time_us( llHdl ) - t;
 
 	 M57_RESET( llHdl->ma, 0);			 /* release reset (run) */
 
@@ -935,8 +1483,10 @@ static int32 PROFIDP_Init(
     +------------------------------*/
 
  	llHdl->intFlagReq       = 1;   /* int intFalg */
-	llHdl->con_ind_num_el   = 0;   /* set actual number of CON/IND buffer to 0 */
+	llHdl->con_ind_in_cnt   = 0;   /* set actual number of CON/IND buffer to 0 */
+	llHdl->con_ind_out_cnt  = 0;
 	llHdl->con_ind_buf_full = 0;   /* init CON/IND buffer full flag */
+	llHdl->conIndHeldCnt    = 0;
 	llHdl->allCh            = 0;   /* flag locks semaphore while reading/writing to/from all ch */
 	llHdl->conIndTimeout    = TIMEOUT_DEFAULT; /* set default timeout value */
 	llHdl->fm2EventReason   = 0;   /* initialize FMB_FM2_EVENT variable */
@@ -946,19 +1496,9 @@ static int32 PROFIDP_Init(
 		llHdl->chInfo[i].num_out = 0;
 	}
 
-	/* initialize chDiag array */
-	for ( i = 0; i < (DP_MAX_NUMBER_SLAVES + 1); i++) {
-		T_DP_DIAG_DATA *diag = (T_DP_DIAG_DATA *)&llHdl->chDiag[i][0];
-
-		diag->station_status_1 = DP_DIAG_1_STATION_NON_EXISTENT;
-		diag->master_add = 0xff;
-	}
-
-	/* initialize FW alive check variables */
-	llHdl->aliveState = PROFIDP_ALIVE_IDLE;
-	llHdl->lastAliveCheck   = 0;
-	llHdl->lastFwDiagConInd = 0;
-	llHdl->fwAliveCheckWait = FALSE;
+	/* no diag store until PROFIDP_Config */
+	for ( i = 0; i < (DP_MAX_NUMBER_SLAVES + 1); i++)
+		llHdl->diagSlot[i] = DP_DIAG_NO_SLOT;
 
 	*llHdlP = llHdl;	/* set low-level driver handle */
 
@@ -1058,10 +1598,21 @@ static int32 PROFIDP_Write(
  *                                                                 UOS_SIG_USR2
  *  PROFIDP_BLK_CONFIG           configure PROFDP device           -
  *  PROFIDP_BLK_SEND_REQ_RES     send request or response          -
+ *  PROFIDP_BLK_SUBMIT_REQ       submit request, don't wait        -
+ *                               (PROFIDP_ASYNC_REQ), CON is got
+ *                               with PROFIDP_BLK_REAP_CPL
  *  PROFIDP_BLK_RVC_CON_IND      get CON/IND out of buffer         -
  *  PROFIDP_BLK_RVC_CON_IND_WAIT wait until CON/IND is available   -
  *                               in buffer and read it out
+ *  PROFIDP_BLK_RCV_CON_IND_MULTI read as many CON/INDs as fit      -
+ *                               (PROFIDP_CON_IND_MULTI), wait for
+ *                               minNum CON/INDs
  *  PROFIDP_BLK_SET_ALL_CH       write values to all output ch.    -
+ *  PROFIDP_BLK_SET_CH_LIST      write values to list of output    -
+ *                               channels (PROFIDP_CH_LIST_ITEM)
+ *  PROFIDP_BLK_SLAVE_PARAM      download parameter set of one     -
+ *                               slave (address followed by
+ *                               T_DP_SLAVE_PARA_SET)
  *  PROFIDP_BLK_START_STACK      start stack STOP-CLEAR-OPERATE    -
  *  PROFIDP_BLK_STOP_STACK       stop stack CLEAR-STOP             -
  *  PROFIDP_BLK_DATA_TRANSFER    do one Data Transfer cycle        -
@@ -1070,6 +1621,28 @@ static int32 PROFIDP_Write(
  *  PROFIDP_SET_STACK_OPERATE    set stack state to OPERATE        non
  *  PROFIDP_WAIT_TIMEOUT         set timeout (sec.) for            0..max
  *                               PROFIDP_BLK_RVC_CON_IND_WAIT
+ *  PROFIDP_SNAPSHOT_PERIOD      set input snapshot period (ms)    0..max
+ *                               0 = off, reads access DPRAM
+ *  PROFIDP_FLUSH_PERIOD         set output shadow flush period    0..max
+ *                               (ms), 0 = off, writes access DPRAM
+ *  PROFIDP_FLUSH_OUTPUTS        write dirty outputs of shadow     -
+ *                               to DPRAM now
+ *  PROFIDP_ALIVE_PERIOD         set firmware alive check period   0..max
+ *                               (ms), 0 = off
+ *  PROFIDP_SIG_ON_CHANGE        send installed signal when        0..1
+ *                               inputs of a slave changed
+ *                               (needs input snapshot)
+ *  PROFIDP_CONFLICT_TIMEOUT     set max wait (ms) for data        1..max
+ *                               descriptor semaphore
+ *  PROFIDP_CONFLICT_SPIN        set nbr of retries before         0..max
+ *                               backing off
+ *  PROFIDP_CONFLICT_STAT_CLR    clear conflict statistics         -
+ *  PROFIDP_CON_IND_POLICY       set CON/IND buffer overflow       see drv.h
+ *                               policy PROFIDP_CON_IND_xxx
+ *  PROFIDP_CON_IND_OVERFLOWS    clear nbr of lost CON/INDs        -
+ *  PROFIDP_CON_IND_HWM          clear CON/IND high-water mark     -
+ *  PROFIDP_SLAVE_ACTIVE         activate/deactivate slave of      0..1
+ *                               current ch.
  *
  *---------------------------------------------------------------------------
  *  Input......:  llHdl           low-level handle
@@ -1096,6 +1669,7 @@ static int32 PROFIDP_SetStat(
 	u_int8 state[] = { DP_ST_STOP, DP_ST_CLEAR, DP_ST_OPERATE };
 	u_int16  con_status;
 	int16     dp_error;
+	u_int32   t;
 
 
     DBGWRT_1((DBH, "LL - PROFIDP_SetStat: ch=%d code=0x%04x value=%08p\n",
@@ -1142,8 +1716,13 @@ static int32 PROFIDP_SetStat(
 				return (PROFIDP_ERR_NO_OUTPUTS);
 			}
 
+			/* write user data block to output shadow */
+			if ( llHdl->flushPeriod && llHdl->outShadow &&
+				 (u_int32) blk->size <= llHdl->outShadowSize ) {
+				PROFIDP_outShadowWrite( llHdl, 0, (u_int32) blk->size, (u_int8*) blk->data );
+			}
 			/* write user data block to output area of DPRAM */
-			if ( (dp_error = (int16) profi_set_data( llHdl, ID_DP_SLAVE_IO_IMAGE, (USIGN16) DP_OUT_POINTER,
+			else if ( (dp_error = (int16) profi_set_data( llHdl, ID_DP_SLAVE_IO_IMAGE, (USIGN16) DP_OUT_POINTER,
 			    (u_int16) blk->size, (u_int8*) blk->data))  != E_OK) {
 				DBGWRT_ERR((DBH, " *** PROFIDP_SetStat: PROFIDP_BLK_SET_ALL_CH failed error code = %04x\n",
 				                 dp_error));
@@ -1159,6 +1738,30 @@ static int32 PROFIDP_SetStat(
 
 			break;
 
+        /*----------------------------------------+
+        |  write values to list of output channels |
+        +-----------------------------------------*/
+		case PROFIDP_BLK_SET_CH_LIST:
+
+			error = PROFIDP_ch_list( llHdl, blk, 1 );
+			break;
+
+       /*-------------------------------+
+        |   submit a request            |
+        +-------------------------------*/
+		case PROFIDP_BLK_SUBMIT_REQ:
+
+			error = PROFIDP_asyncSubmit( llHdl, blk );
+			break;
+
+       /*-------------------------------------+
+        |   download parameters of one slave  |
+        +-------------------------------------*/
+		case PROFIDP_BLK_SLAVE_PARAM:
+
+			error = PROFIDP_slaveParam( llHdl, blk );
+			break;
+
        /*-------------------------------+
         |   send a request or response  |
         +-------------------------------*/
@@ -1166,7 +1769,7 @@ static int32 PROFIDP_SetStat(
 
 			/* send request respons */
 			dp_error = (int16) profi_snd_req_res_usr( llHdl, (T_PROFI_SERVICE_DESCR*) blk->data,
-					((VOID *) ( ((u_int8*) blk->data) + sizeof (T_PROFI_SERVICE_DESCR))), 0);
+					((VOID *) ( ((u_int8*) blk->data) + sizeof (T_PROFI_SERVICE_DESCR))));
 
 			/* if an error occured return error code */
 			if (dp_error != E_OK) {
@@ -1190,7 +1793,7 @@ static int32 PROFIDP_SetStat(
 			}
 
 			/* decrement sem counter if there is one element in buffer */
-			if (llHdl->con_ind_num_el > 0) {
+			if (CON_IND_NUM_EL(llHdl) > 0) {
 				if ((OSS_SemWait( llHdl->osHdl, llHdl->con_buf_semP, OSS_SEM_NOWAIT )) != 0) {
 					DBGWRT_ERR((DBH," *** PROFIDP_SetStat: Error or Timeout waiting for CON/IND buffer semaphore\n"));
 					return (PROFIDP_ERR_CON_IND_SEM);
@@ -1198,7 +1801,7 @@ static int32 PROFIDP_SetStat(
 			}
 
 			/* look for element in buffer */
-			if (llHdl->con_ind_num_el == 0) {
+			if (CON_IND_NUM_EL(llHdl) == 0) {
 				DBGWRT_ERR((DBH,"*** PROFIDP_BLK_RVC_CON_IND: No CON/IND available\n"));
 				return (PROFIDP_ERR_NO_CON_IND);
 			}
@@ -1232,14 +1835,33 @@ static int32 PROFIDP_SetStat(
 
 			break;
 
+        /*----------------------------------------------+
+        |  receive multiple confirmations/indications   |
+        +----------------------------------------------*/
+		case PROFIDP_BLK_RCV_CON_IND_MULTI:
+
+			error = PROFIDP_outConIndMulti( llHdl, blk );
+			break;
+
         /*------------------------------------------+
         |   set Profibus stack from STOP to OPERATE |
         +------------------------------------------*/
 		case PROFIDP_START_STACK:
 
+			/* re-attached stack is still running */
+			if( llHdl->reattached && llHdl->stackState == DP_ST_OPERATE ){
+				DBGWRT_2((DBH, "LL - PROFIDP_SetStat: stack already in OPERATE\n"));
+				break;
+			}
+
 			/* set protocol stack in modes STOP, CLEAR, OPERATE */
+			for( i=0; i<3; i++)
+				llHdl->tPhase[DP_T_STACK_STOP + i] = 0;
+
 			for( i=0; i<3; i++){
+				t = dp_time_us( llHdl );
 				dp_error = dp_setstate( llHdl, state[i], &con_status );
+				llHdl->tPhase[DP_T_STACK_STOP + i] = dp_time_us( llHdl ) - t;
 
 				if( dp_error == -1 ){
 					DBGWRT_ERR((DBH, " *** PROFIDP Set Stat: Error setting mode to %02x\n", state[i]));
@@ -1355,33 +1977,160 @@ static int32 PROFIDP_SetStat(
 
 			break;
 
-       /*-------------------------------+
-        |   install signal              |
-        +-------------------------------*/
-		case PROFIDP_SIG_ON_EVENT_SET:   /* Install Signal on event */
-			if (llHdl->sigHdl != NULL) {
-				DBGWRT_ERR((DBH, " *** PROFIDP_SetStat: signal already installed\n"));
-				return (ERR_OSS_SIG_SET);
-			}
-
-			/* install signal */
-			if ( (error = OSS_SigCreate(llHdl->osHdl, value, &llHdl->sigHdl)))
+        /*------------------------------------------------+
+        |  set input snapshot period                      |
+        +------------------------------------------------*/
+		case PROFIDP_SNAPSHOT_PERIOD:
+			if ( value && llHdl->snapBuf == NULL && DP_OUT_POINTER != 0 &&
+				 (error = PROFIDP_snapAlloc( llHdl )) != ERR_SUCCESS )
 				return (error);
 
+			llHdl->snapPeriod = (u_int32) value;
+
+			if ( value == 0 )
+				llHdl->snapValid = 0;	/* reads access DPRAM again */
+			else
+				OSS_SemSignal( llHdl->osHdl, llHdl->snapSemP );
 
 			break;
 
-       /*-------------------------------+
-        |   uninstall signal            |
-        +-------------------------------*/
-		case PROFIDP_SIG_ON_EVENT_CLR:   /* remove signal */
+        /*------------------------------------------------+
+        |  set firmware alive check period                |
+        +------------------------------------------------*/
+		case PROFIDP_ALIVE_PERIOD:
+			llHdl->alivePeriod = (u_int32) value;
+			OSS_SemSignal( llHdl->osHdl, llHdl->aliveSemP );
+			break;
 
-			if (llHdl->sigHdl == NULL) {
-				DBGWRT_ERR((DBH, " *** PROFIDP_SetStat: no signal installed\n"));
-				return (ERR_OSS_SIG_CLR);
-			}
+        /*------------------------------------------------+
+        |  set output shadow flush period                 |
+        +------------------------------------------------*/
+		case PROFIDP_FLUSH_PERIOD:
+			llHdl->flushPeriod = (u_int32) value;
 
-			/* uninstall signal */
+			if ( value == 0 )
+				error = PROFIDP_flushOutputs( llHdl ); /* write pending outputs */
+			else
+				OSS_SemSignal( llHdl->osHdl, llHdl->flushSemP );
+
+			break;
+
+        /*------------------------------------------------+
+        |  write dirty outputs of shadow now              |
+        +------------------------------------------------*/
+		case PROFIDP_FLUSH_OUTPUTS:
+			error = PROFIDP_flushOutputs( llHdl );
+
+			break;
+
+        /*------------------------------------------------+
+        |  send signal on input change                    |
+        +------------------------------------------------*/
+		case PROFIDP_SIG_ON_CHANGE:
+			llHdl->chgSig = (u_int8) (value ? 1 : 0);
+
+			break;
+
+        /*------------------------------------------------+
+        |  set data descriptor conflict handling          |
+        +------------------------------------------------*/
+		case PROFIDP_CONFLICT_TIMEOUT:
+			if ( value < 1 )
+				return (ERR_LL_ILL_PARAM);
+			llHdl->conflictTimeout = (u_int32) value;
+
+			break;
+
+		case PROFIDP_CONFLICT_SPIN:
+			if ( value < 0 )
+				return (ERR_LL_ILL_PARAM);
+			llHdl->conflictSpin = (u_int32) value;
+
+			break;
+
+		case PROFIDP_CON_IND_POLICY:
+			if ( value < PROFIDP_CON_IND_DROP_NEWEST || value > PROFIDP_CON_IND_BLOCK )
+				return (ERR_LL_ILL_PARAM);
+
+			/* reader and ISR-Task lock differently per policy */
+			if( ERROR == semTake( llHdl->windowPointerSemId, WAIT_FOREVER ) ) {
+				DBGWRT_ERR((DBH," *** PROFIDP_SetStat: Error taking window pointer semaphore\n"));
+			}
+			llHdl->con_ind_policy = (u_int32) value;
+			/* store queued CON/INDs with the new policy */
+			PROFIDP_conIndFlushHeld( llHdl );
+			if( ERROR == semGive( llHdl->windowPointerSemId ) ) {
+				DBGWRT_ERR((DBH," *** PROFIDP_SetStat: Error giving window pointer semaphore\n"));
+			}
+
+			break;
+
+		case PROFIDP_CON_IND_OVERFLOWS:
+			llHdl->con_ind_overflows = 0;
+
+			break;
+
+		case PROFIDP_CON_IND_HWM:
+			llHdl->con_ind_hwm = CON_IND_NUM_EL(llHdl);
+
+			break;
+
+        /*-----------------------------------+
+        |  activate/deactivate one slave     |
+        +-----------------------------------*/
+		case PROFIDP_SLAVE_ACTIVE:
+			if ( ch < 0 || ch >= DP_MAX_NUMBER_SLAVES || llHdl->max_slave_para_len == 0 ) {
+				DBGWRT_ERR((DBH, " *** PROFIDP_SetStat: can't activate slave %d\n", ch));
+				return (ERR_LL_ILL_CHAN);
+			}
+
+			dp_error = dp_act_slave( llHdl, (u_int8) ch,
+									 value ? DP_SLAVE_ACTIVATE : DP_SLAVE_DEACTIVATE,
+									 &con_status );
+			if ( dp_error ) {
+				DBGWRT_ERR((DBH, " *** PROFIDP_SetStat: Can't (de)activate slave %d."
+							" status=%x\n", ch, dp_error == 1 ? con_status : 0));
+				return (PROFIDP_ERR_SLAVE_PARAM);
+			}
+
+			break;
+
+		case PROFIDP_CONFLICT_STAT_CLR:
+			llHdl->conflictCnt      = 0;
+			llHdl->conflictTimeouts = 0;
+			llHdl->conflictMaxWait  = 0;
+			OSS_MemFill( llHdl->osHdl, sizeof(llHdl->conflictHist),
+						 (char*) llHdl->conflictHist, 0x00 );
+
+			break;
+
+       /*-------------------------------+
+        |   install signal              |
+        +-------------------------------*/
+		case PROFIDP_SIG_ON_EVENT_SET:   /* Install Signal on event */
+			if (llHdl->sigHdl != NULL) {
+				DBGWRT_ERR((DBH, " *** PROFIDP_SetStat: signal already installed\n"));
+				return (ERR_OSS_SIG_SET);
+			}
+
+			/* install signal */
+			if ( (error = OSS_SigCreate(llHdl->osHdl, value, &llHdl->sigHdl)))
+				return (error);
+
+
+			break;
+
+       /*-------------------------------+
+        |   uninstall signal            |
+        +-------------------------------*/
+		case PROFIDP_SIG_ON_EVENT_CLR:   /* remove signal */
+
+			if (llHdl->sigHdl == NULL) {
+				DBGWRT_ERR((DBH, " *** PROFIDP_SetStat: no signal installed\n"));
+				return (ERR_OSS_SIG_CLR);
+			}
+
+			/* uninstall signal */
 			if ( (error = OSS_SigRemove(llHdl->osHdl, &llHdl->sigHdl)))
 				return (error);
 			break;
@@ -1394,6 +2143,9 @@ static int32 PROFIDP_SetStat(
 				DBGWRT_ERR((DBH, " *** PROFIDP_SetStat: PROFIDP_BLK_CONFIG failed\n"));
 				return (PROFIDP_ERR_CONFIG);
 			}
+			/* configured, but the snapshot enabled can't be used */
+			if (llHdl->snapPeriod && llHdl->snapBuf == NULL && DP_OUT_POINTER != 0)
+				return (ERR_OSS_MEM_ALLOC);
 			break;
 
         /*--------------------------+
@@ -1459,6 +2211,34 @@ static int32 PROFIDP_SetStat(
  *       M_LL_BLK_ID_DATA               EEPROM raw data             -
  *       M_MK_BLK_REV_ID                ident function table ptr    -
  *       PROFIDP_BLK_GET_ALL_CH         read all input channels     -
+ *       PROFIDP_BLK_GET_CH_LIST        read list of input channels -
+ *                                      (PROFIDP_CH_LIST_ITEM)
+ *       PROFIDP_BLK_GET_CHANGED        get and clear bitmap of     -
+ *                                      slaves with changed inputs
+ *                                      (PROFIDP_CHANGED_SIZE bytes,
+ *                                      bit n%8 of byte n/8 = slave
+ *                                      address n, needs snapshot)
+ *       PROFIDP_BLK_GET_NEW_DIAG       get and clear bitmap of     -
+ *                                      slaves with new diag
+ *                                      (as PROFIDP_BLK_GET_CHANGED)
+ *       PROFIDP_BLK_GET_DIAG_HIST      get and remove as many      -
+ *                                      slave diag history records
+ *                                      as fit (PROFIDP_DIAG_REC),
+ *                                      oldest first
+ *       PROFIDP_BLK_LIVE_LIST          get slaves in data exchange -
+ *                                      from DP status image
+ *                                      (PROFIDP_LIVE_LIST)
+ *       PROFIDP_BLK_CONFLICT_STAT      get data descriptor         -
+ *                                      semaphore conflict statistics
+ *                                      (PROFIDP_CONFLICT_STAT)
+ *       PROFIDP_BLK_STARTUP_TIME       get times of startup phases -
+ *                                      of M_open, PROFIDP_BLK_CONFIG
+ *                                      and PROFIDP_START_STACK
+ *                                      (PROFIDP_STARTUP_TIME)
+ *       PROFIDP_BLK_REAP_CPL           get as many completions of  -
+ *                                      submitted requests as fit
+ *                                      (PROFIDP_ASYNC_REAP), wait
+ *                                      for minNum completions
  *       PROFIDP_BLK_GET_DIAG           do Get_Slave_Diag service   -
  *       PROFIDP_BLK_GET_SLAVE_DIAG     get diag for current ch.
  *       PROFIDP_WAIT_TIMEOUT           get timeout (sec.) for      0..max
@@ -1483,6 +2263,34 @@ static int32 PROFIDP_SetStat(
  *       PROFIDP_MAX_OUTPUT_LEN         get max slave output length  0..max
  *       PROFIDP_CH_INPUT_LEN           get slave input length       0..max
  *       PROFIDP_CH_OUTPUT_LEN          get slave output length      0..max
+ *       PROFIDP_SNAPSHOT_PERIOD        get input snapshot period    0..max
+ *                                      (ms), 0 = off
+ *       PROFIDP_SNAPSHOT_AGE           get age of input snapshot    0..max
+ *                                      (ms), -1 = no snapshot
+ *       PROFIDP_FLUSH_PERIOD           get output shadow flush      0..max
+ *                                      period (ms), 0 = off
+ *       PROFIDP_SIG_ON_CHANGE          get signal on input change   0..1
+ *       PROFIDP_CONFLICT_TIMEOUT       get max wait (ms) for data   1..max
+ *                                      descriptor semaphore
+ *       PROFIDP_CONFLICT_SPIN          get nbr of retries before    0..max
+ *                                      backing off
+ *       PROFIDP_CON_IND_POLICY         get CON/IND buffer overflow  see drv.h
+ *                                      policy
+ *       PROFIDP_CON_IND_OVERFLOWS      get nbr of lost CON/INDs     0..max
+ *       PROFIDP_CON_IND_HWM            get max nbr of CON/INDs in   0..max
+ *                                      buffer
+ *       PROFIDP_ASYNC_PENDING          get nbr of submitted, not    0..max
+ *                                      reaped requests
+ *       PROFIDP_CONFIG_HASH            get hash of current          0..max
+ *                                      configuration (CONFIG_HASH)
+ *       PROFIDP_REATTACHED             get running firmware was     0..1
+ *                                      re-attached (HOT_REATTACH)
+ *       PROFIDP_DIAG_GEN               get nbr of diag changes of   0..max
+ *                                      slave (current ch.)
+ *       PROFIDP_ALIVE_PERIOD           get firmware alive check     0..max
+ *                                      period (ms), 0 = off
+ *       PROFIDP_FW_ALIVE               get result of last firmware  0..1
+ *                                      alive check
  *
  *---------------------------------------------------------------------------
  *  Input......:  llHdl            low-level handle
@@ -1534,8 +2342,9 @@ static int32 PROFIDP_GetStat(
 				return (PROFIDP_ERR_NO_INPUTS);
 			}
 
-			/* read input data from input area of DPRAM */
-			if (profi_get_data( llHdl, ID_DP_SLAVE_IO_IMAGE, (USIGN16) 0, &dataSize,
+			/* read input data from snapshot or input area of DPRAM */
+			if (PROFIDP_snapRead( llHdl, 0, &dataSize, (u_int8*) blk->data ) &&
+				profi_get_data( llHdl, ID_DP_SLAVE_IO_IMAGE, (USIGN16) 0, &dataSize,
 			                    (u_int8*) blk->data)  != E_OK) { /* inputs have offset 0 */
 				DBGWRT_ERR((DBH, " *** PROFIDP_GetStat: PROFIDP_BLK_SET_DATA failed\n"));
 				return (PROFIDP_ERR_GET_DATA);
@@ -1552,6 +2361,173 @@ static int32 PROFIDP_GetStat(
             break;
 
 
+        /*----------------------------------+
+        |   live list from status image     |
+        +----------------------------------*/
+        case PROFIDP_BLK_LIVE_LIST:
+
+			if ( blk->size < sizeof(PROFIDP_LIVE_LIST) ) {
+				DBGWRT_ERR((DBH, " *** PROFIDP_GetStat: live list buffer to small\n"));
+				return (ERR_LL_USERBUF);
+			}
+
+			error = PROFIDP_liveList( llHdl, (PROFIDP_LIVE_LIST*) blk->data );
+			blk->size = sizeof(PROFIDP_LIVE_LIST);
+			break;
+
+        /*----------------------------------+
+        |   read data from list of channels |
+        +----------------------------------*/
+        case PROFIDP_BLK_GET_CH_LIST:
+
+			error = PROFIDP_ch_list( llHdl, blk, 0 );
+			break;
+
+        /*----------------------------------+
+        |   get and clear changed bitmap    |
+        +----------------------------------*/
+        case PROFIDP_BLK_GET_CHANGED:
+        {
+			u_int32 i;
+
+			if ( blk->size < PROFIDP_CHANGED_SIZE ) {
+				DBGWRT_ERR((DBH, " *** PROFIDP_GetStat: changed bitmap buffer to small\n"));
+				return (ERR_LL_USERBUF);
+			}
+
+			/* read and clear in one step */
+			OSS_SemWait( llHdl->osHdl, llHdl->chgSemP, OSS_SEM_WAITFOREVER );
+			for ( i = 0; i < PROFIDP_CHANGED_SIZE; i++ )
+				((u_int8*) blk->data)[i] = (u_int8) (llHdl->chgBits[i / 4] >> ((i % 4) * 8));
+			for ( i = 0; i < DP_CHG_WORDS; i++ )
+				llHdl->chgBits[i] = 0;
+			OSS_SemSignal( llHdl->osHdl, llHdl->chgSemP );
+
+			blk->size = PROFIDP_CHANGED_SIZE;
+			break;
+        }
+
+        /*----------------------------------+
+        |   get and clear new diag bitmap   |
+        +----------------------------------*/
+        case PROFIDP_BLK_GET_NEW_DIAG:
+        {
+			u_int32 i;
+
+			if ( blk->size < PROFIDP_CHANGED_SIZE ) {
+				DBGWRT_ERR((DBH, " *** PROFIDP_GetStat: new diag bitmap buffer to small\n"));
+				return (ERR_LL_USERBUF);
+			}
+
+			/* ISR-Task sets bits with window pointer semaphore taken */
+			semTake( llHdl->windowPointerSemId, WAIT_FOREVER );
+			for ( i = 0; i < PROFIDP_CHANGED_SIZE; i++ )
+				((u_int8*) blk->data)[i] = (u_int8) (llHdl->diagBits[i / 4] >> ((i % 4) * 8));
+			for ( i = 0; i < DP_CHG_WORDS; i++ )
+				llHdl->diagBits[i] = 0;
+			semGive( llHdl->windowPointerSemId );
+
+			blk->size = PROFIDP_CHANGED_SIZE;
+			break;
+        }
+
+        /*----------------------------------+
+        |   drain slave diag history        |
+        +----------------------------------*/
+        case PROFIDP_BLK_GET_DIAG_HIST:
+        {
+			PROFIDP_DIAG_REC *rec = (PROFIDP_DIAG_REC*) blk->data;
+			u_int32 n = 0;
+
+			if ( blk->size < sizeof(PROFIDP_DIAG_REC) ) {
+				DBGWRT_ERR((DBH, " *** PROFIDP_GetStat: diag history buffer to small\n"));
+				return (ERR_LL_USERBUF);
+			}
+
+			/* ISR-Task adds records with window pointer semaphore taken */
+			semTake( llHdl->windowPointerSemId, WAIT_FOREVER );
+			while ( llHdl->diagHistCnt &&
+					(n + 1) * sizeof(PROFIDP_DIAG_REC) <= (u_int32) blk->size ) {
+				OSS_MemCopy( llHdl->osHdl, sizeof(PROFIDP_DIAG_REC),
+							 (char*) llHdl->diagHist + llHdl->diagHistRd *
+							 sizeof(PROFIDP_DIAG_REC), (char*) &rec[n] );
+				if ( ++llHdl->diagHistRd == llHdl->diagHistNum )
+					llHdl->diagHistRd = 0;
+				llHdl->diagHistCnt--;
+				n++;
+			}
+			semGive( llHdl->windowPointerSemId );
+
+			blk->size = n * sizeof(PROFIDP_DIAG_REC);
+			break;
+        }
+
+        /*----------------------------------+
+        |   get conflict statistics         |
+        +----------------------------------*/
+        case PROFIDP_BLK_CONFLICT_STAT:
+        {
+			PROFIDP_CONFLICT_STAT *stat = (PROFIDP_CONFLICT_STAT*) blk->data;
+			u_int32 i;
+
+			if ( blk->size < sizeof(PROFIDP_CONFLICT_STAT) ) {
+				DBGWRT_ERR((DBH, " *** PROFIDP_GetStat: conflict stat buffer to small\n"));
+				return (ERR_LL_USERBUF);
+			}
+
+			stat->count    = llHdl->conflictCnt;
+			stat->timeouts = llHdl->conflictTimeouts;
+			stat->maxWait  = llHdl->conflictMaxWait;
+			for ( i = 0; i < PROFIDP_CONFLICT_HIST_NUM; i++ )
+				stat->hist[i] = llHdl->conflictHist[i];
+
+			blk->size = sizeof(PROFIDP_CONFLICT_STAT);
+			break;
+        }
+
+        /*----------------------------------+
+        |   get startup phase times         |
+        +----------------------------------*/
+        case PROFIDP_BLK_STARTUP_TIME:
+        {
+			PROFIDP_STARTUP_TIME *st = (PROFIDP_STARTUP_TIME*) blk->data;
+			u_int32 i;
+
+			if ( blk->size < sizeof(PROFIDP_STARTUP_TIME) ) {
+				DBGWRT_ERR((DBH, " *** PROFIDP_GetStat: startup time buffer to small\n"));
+				return (ERR_LL_USERBUF);
+			}
+
+			st->resolution    = DP_TIME_RES;
+			st->fwValidate    = llHdl->tPhase[DP_T_FW_VALIDATE];
+			st->fwLoad        = llHdl->tPhase[DP_T_FW_LOAD];
+			st->fwVerify      = llHdl->tPhase[DP_T_FW_VERIFY];
+			st->cmiReady      = llHdl->tPhase[DP_T_CMI_READY];
+			st->cmiConfigMode = llHdl->tPhase[DP_T_CMI_CONFIG_MODE];
+			st->cmiInit       = llHdl->tPhase[DP_T_CMI_INIT];
+			st->fmbSetConfig  = llHdl->tPhase[DP_T_FMB_SET_CONFIG];
+			st->dpInitMaster  = llHdl->tPhase[DP_T_INIT_MASTER];
+			st->busParaDl     = llHdl->tPhase[DP_T_BUS_PARA_DL];
+			st->slaveParaDl   = llHdl->tPhase[DP_T_SLAVE_PARA_DL];
+			st->config        = llHdl->tPhase[DP_T_CONFIG];
+			st->stackStop     = llHdl->tPhase[DP_T_STACK_STOP];
+			st->stackClear    = llHdl->tPhase[DP_T_STACK_CLEAR];
+			st->stackOperate  = llHdl->tPhase[DP_T_STACK_OPERATE];
+			for ( i = 0; i < PROFIDP_STARTUP_SLAVES; i++ )
+				st->slaveDl[i] = llHdl->tSlaveDl[i];
+
+			blk->size = sizeof(PROFIDP_STARTUP_TIME);
+			break;
+        }
+
+        /*----------------------------------+
+        |   get completions                 |
+        +----------------------------------*/
+        case PROFIDP_BLK_REAP_CPL:
+
+			error = PROFIDP_asyncReap( llHdl, blk );
+			break;
+
         /*-------------------------------+
         |   do diag request service      |
         +-------------------------------*/
@@ -1580,7 +2556,21 @@ static int32 PROFIDP_GetStat(
 				DBGWRT_ERR((DBH," *** PROFIDP_aliveCheck: Error taking window pointer semaphore\n"));
 			}
 
-			OSS_MemCopy(llHdl->osHdl, blk->size, (char*) &llHdl->chDiag[ch][0], (char*) blk->data);
+			if ( ch <= DP_MAX_NUMBER_SLAVES && llHdl->diagSlot[ch] != DP_DIAG_NO_SLOT ) {
+				if ( blk->size > llHdl->diagEntrySize )
+					blk->size = llHdl->diagEntrySize;
+				OSS_MemCopy(llHdl->osHdl, blk->size,
+							(char*) DP_DIAG_ENTRY(llHdl, llHdl->diagSlot[ch]), (char*) blk->data);
+			}
+			else {
+				/* slave not configured */
+				T_DP_DIAG_DATA *diag = (T_DP_DIAG_DATA*) blk->data;
+
+				blk->size = sizeof(T_DP_DIAG_DATA);
+				OSS_MemFill(llHdl->osHdl, blk->size, (char*) diag, 0x00);
+				diag->station_status_1 = DP_DIAG_1_STATION_NON_EXISTENT;
+				diag->master_add = 0xff;
+			}
 
 			if( ERROR == semGive( llHdl->windowPointerSemId ) ) {
 				DBGWRT_ERR((DBH," *** PROFIDP_aliveCheck: Error giving window pointer semaphore\n"));
@@ -1601,7 +2591,7 @@ static int32 PROFIDP_GetStat(
         |  get number of elements in CON/IND buffer       |
         +------------------------------------------------*/
 		case PROFIDP_NUM_CON_IND:
-			*valueP = (int32) llHdl->con_ind_num_el;
+			*valueP = (int32) CON_IND_NUM_EL(llHdl);
 
 			break;
 
@@ -1660,6 +2650,108 @@ static int32 PROFIDP_GetStat(
 			*valueP = (int32) llHdl->chInfo[ch].num_out;
 			break;
 
+        /*------------------------------------------------+
+        |  get input snapshot period                      |
+        +------------------------------------------------*/
+		case PROFIDP_SNAPSHOT_PERIOD:
+			*valueP = (int32) llHdl->snapPeriod;
+			break;
+
+        /*------------------------------------------------+
+        |  get output shadow flush period                 |
+        +------------------------------------------------*/
+		case PROFIDP_FLUSH_PERIOD:
+			*valueP = (int32) llHdl->flushPeriod;
+			break;
+
+        /*------------------------------------------------+
+        |  get firmware alive check period and result     |
+        +------------------------------------------------*/
+		case PROFIDP_ALIVE_PERIOD:
+			*valueP = (int32) llHdl->alivePeriod;
+			break;
+
+		case PROFIDP_FW_ALIVE:
+			*valueP = (int32) llHdl->fwAlive;
+			break;
+
+        /*------------------------------------------------+
+        |  get signal on input change                     |
+        +------------------------------------------------*/
+		case PROFIDP_SIG_ON_CHANGE:
+			*valueP = (int32) llHdl->chgSig;
+			break;
+
+        /*------------------------------------------------+
+        |  get data descriptor conflict handling          |
+        +------------------------------------------------*/
+		case PROFIDP_CONFLICT_TIMEOUT:
+			*valueP = (int32) llHdl->conflictTimeout;
+			break;
+
+		case PROFIDP_CONFLICT_SPIN:
+			*valueP = (int32) llHdl->conflictSpin;
+			break;
+
+        /*------------------------------------------------+
+        |  get CON/IND buffer statistics                  |
+        +------------------------------------------------*/
+		case PROFIDP_CON_IND_POLICY:
+			*valueP = (int32) llHdl->con_ind_policy;
+			break;
+
+		case PROFIDP_CON_IND_OVERFLOWS:
+			*valueP = (int32) llHdl->con_ind_overflows;
+			break;
+
+		case PROFIDP_CON_IND_HWM:
+			*valueP = (int32) llHdl->con_ind_hwm;
+			break;
+
+		case PROFIDP_ASYNC_PENDING:
+		{
+			int32 n, num = 0;
+
+			for ( n = 0; n < DP_MAX_PEND_REQ; n++ )
+				if ( llHdl->pendReq[n].used && llHdl->pendReq[n].async )
+					num++;
+			*valueP = num;
+			break;
+		}
+
+        /*------------------------------------------------+
+        |  get hot reattach state                         |
+        +------------------------------------------------*/
+		case PROFIDP_CONFIG_HASH:
+			*valueP = (int32) llHdl->cfgHash;
+			break;
+
+		case PROFIDP_REATTACHED:
+			*valueP = (int32) llHdl->reattached;
+			break;
+
+        /*------------------------------------------------+
+        |  get diag generation of slave                   |
+        +------------------------------------------------*/
+		case PROFIDP_DIAG_GEN:
+			*valueP = ch < DP_MAX_NUMBER_SLAVES ? (int32) llHdl->diagGen[ch] : 0;
+			break;
+
+        /*------------------------------------------------+
+        |  get age of input snapshot                      |
+        +------------------------------------------------*/
+		case PROFIDP_SNAPSHOT_AGE:
+			if ( llHdl->snapPeriod && llHdl->snapValid ) {
+				u_int32 ticks = ((u_int32) ACT_TICK) - llHdl->snapTick;
+				u_int32 rate  = (u_int32) TICK_RATE;
+
+				*valueP = (int32) ((ticks / rate) * 1000 +
+								   ((ticks % rate) * 1000) / rate);
+			}
+			else
+				*valueP = -1;
+			break;
+
         /*--------------------------+
         |  debug level              |
         +--------------------------*/
@@ -1775,8 +2867,9 @@ static int32 PROFIDP_BlockRead(
 		return (ERR_LL_USERBUF);
 	}
 
-	/* read data for slave out of DPRAM */
-	if (profi_get_data( llHdl, ID_DP_SLAVE_IO_IMAGE, (USIGN16) DP_ARRAY_OFFSET_IN (ch), &dataSize, buf)
+	/* read data for slave out of snapshot or DPRAM */
+	if (PROFIDP_snapRead( llHdl, (u_int32) DP_ARRAY_OFFSET_IN (ch), &dataSize, buf ) &&
+	    profi_get_data( llHdl, ID_DP_SLAVE_IO_IMAGE, (USIGN16) DP_ARRAY_OFFSET_IN (ch), &dataSize, buf)
 	    != E_OK) {
 		DBGWRT_ERR((DBH, " *** PROFIDP_BlockRead: PROFIDP_BLK_SET_DATA failed\n"));
 		return (PROFIDP_ERR_GET_DATA);
@@ -1834,8 +2927,13 @@ static int32 PROFIDP_BlockWrite(
 		return (ERR_LL_USERBUF);
 	}
 
+	/* write output data for slave to output shadow */
+	if ( llHdl->flushPeriod && llHdl->outShadow ) {
+		PROFIDP_outShadowWrite( llHdl, (u_int32) (DP_ARRAY_OFFSET_OUT (ch) - DP_OUT_POINTER),
+								dataSize, buf );
+	}
 	/* write output data for slave to DPRAM */
-	if (profi_set_data( llHdl, ID_DP_SLAVE_IO_IMAGE, (USIGN16) DP_ARRAY_OFFSET_OUT (ch),
+	else if (profi_set_data( llHdl, ID_DP_SLAVE_IO_IMAGE, (USIGN16) DP_ARRAY_OFFSET_OUT (ch),
 	    dataSize, buf)  != E_OK) {
 			DBGWRT_ERR((DBH, " *** PROFIDP_BlockWrite: PROFIDP_BLK_SET_DATA failed\n"));
 			return (PROFIDP_ERR_SET_DATA);
@@ -1906,6 +3004,7 @@ static int PROFIDP_IsrTask(LL_HANDLE *llHdl)
     T_DP_DIAG_DATA*            diagData;
     T_FMB_FM2_EVENT_IND*       fm2;
 	u_int8  irqVal;
+	int     stored;
 
 	while( 1 ) {
 
@@ -1913,9 +3012,9 @@ static int PROFIDP_IsrTask(LL_HANDLE *llHdl)
 			perror ("taskSafe");
 			return 1;
 		}
+
 		if (0 != OSS_SemWait( llHdl->osHdl,
 				llHdl->isrTaskSemP, OSS_SEM_WAITFOREVER ))
-			
 			return 1;
 		IDBGWRT_1((DBH, " >>> !!! PROFIDP_IrqTask <<<: ma = 0x%08x \n", llHdl->ma));
 
@@ -1926,7 +3025,8 @@ static int PROFIDP_IsrTask(LL_HANDLE *llHdl)
 		}
 
 
-		irqVal = (u_int8) DP_READ_INT8( llHdl->ma, COFF(H_ID));
+		SET_WINDOW(llHdl->ma, COMM_OFF); /* set window to CMI descriptor */
+		irqVal = (u_int8) MREAD_D8( llHdl->ma, H_ID );
 
 		llHdl->irqFlag = 1;
 
@@ -1941,13 +3041,23 @@ static int PROFIDP_IsrTask(LL_HANDLE *llHdl)
 					/* clear flag getSlaveDiagReqWaitAck */
 					llHdl->getSlaveDiagReqWaitAck = FALSE;
 				}
-				else {
+				else if( llHdl->reqPending ){
+					/* take result before the next request can be sent */
+					llHdl->reqRetVal = (u_int8) MREAD_D8( llHdl->ma, H_RET_VAL );
+					MWRITE_D8( llHdl->ma, H_RET_VAL, E_OK );
+					MWRITE_D8( llHdl->ma, H_SEMA, _IDLE );
+					llHdl->reqPending = FALSE;
+
 					if ((OSS_SemSignal( llHdl->osHdl, llHdl->req_con_f0_semP )) != 0) {
 						DBGWRT_ERR((DBH," *** PROFIDP_IrqTask: Error signaling REQ/CON semaphore\n"));
 						return 1;
 					}
 				}
-				llHdl->reqPending = FALSE;
+				else {
+					/* late ACK, sender gave up */
+					DBGWRT_ERR((DBH," *** PROFIDP_IrqTask: ACK without pending request\n"));
+					MWRITE_D8( llHdl->ma, H_SEMA, _IDLE );
+				}
 
 				break;
 
@@ -1965,25 +3075,13 @@ static int PROFIDP_IsrTask(LL_HANDLE *llHdl)
 					IDBGWRT_1((DBH, " >>> PROFIDP_IrqTask: c_sdb.service = %02x c_sdb.primitive = %02x "
 									 "c_sdb.layer = %02x \n", c_sdb.service , c_sdb.primitive, c_sdb.layer));
 				}
+				else
+					llHdl->fwActivity++;	/* firmware is alive */
 				IDBGWRT_3((DBH, " >>> PROFIDP_IrqTask: c_sdb.service = %02x c_sdb.primitive = %02x "
 								 "c_sdb.layer = %02x\n",
 								  c_sdb.service , c_sdb.primitive, c_sdb.layer));
 				/* check if driver is internally waiting for CON/IND */
-				if(	(llHdl->waitForService.layer == c_sdb.layer && llHdl->waitForService.service == c_sdb.service &&
-				 llHdl->waitForService.primitive == c_sdb.primitive) /* || llHdl->conIndWaitFalg == 1 */ ) {
-
-					OSS_MemCopy(llHdl->osHdl, sizeof (llHdl->req_con_buf), (char*) llHdl->con_buf,
-								(char*) (llHdl->req_con_buf));
-
-					llHdl->waitForService.invoke_id = c_sdb.invoke_id;
-					llHdl->waitForService.result    = c_sdb.result;
-					llHdl->waitForService.comm_ref  = c_sdb.comm_ref;
-
-					/* signal semaphore */
-					if ((OSS_SemSignal( llHdl->osHdl, llHdl->req_con_0f_semP )) != 0) {
-						DBGWRT_ERR((DBH," *** PROFIDP_Init: Error signaling REQ/CON semaphore\n"));
-						return 1;
-					}
+				if(	PROFIDP_pendReqComplete( llHdl, &c_sdb, llHdl->con_buf, con_size ) ) {
 
 					/* send diag request immediately after pendig user request */
 					if (llHdl->getSlaveDiagReqDelayed) {
@@ -1996,11 +3094,32 @@ static int PROFIDP_IsrTask(LL_HANDLE *llHdl)
 
 					if ( !llHdl->cyclicDataTransfer ) {
 
-						/* save CON/IND in buffer */
-						PROFIDP_inConIndBuffer ( llHdl, &c_sdb, llHdl->con_buf );
-
-						/* give semaphore for CON/IND buffer if no overflow has occured */
-						if (llHdl->con_ind_buf_full != 0x01) {
+						/* save CON/IND in buffer behind queued ones,
+						   give semaphore for CON/IND buffer if nbr of elements increased */
+						PROFIDP_conIndFlushHeld( llHdl );
+						stored = llHdl->conIndHeldCnt ? -1 :
+							PROFIDP_inConIndBuffer ( llHdl, &c_sdb, llHdl->con_buf, con_size );
+						if ( stored < 0 ) {
+							/* no space (policy block), queue it until the
+							   reader frees space, H_ID is acked anyway */
+							if ( llHdl->conIndHeldCnt < CON_IND_HELD_NUM ) {
+								CON_IND_HELD *held = &llHdl->conIndHeld[
+									(llHdl->conIndHeldRd + llHdl->conIndHeldCnt) % CON_IND_HELD_NUM];
+
+								if ( con_size > DP_MAX_TELEGRAM_LEN )
+									con_size = DP_MAX_TELEGRAM_LEN;
+								held->sdb = c_sdb;
+								held->len = con_size;
+								OSS_MemCopy( llHdl->osHdl, con_size, (char*) llHdl->con_buf,
+											 (char*) held->data );
+								llHdl->conIndHeldCnt++;
+							}
+							else {
+								IDBGWRT_ERR((DBH, " >>> *** PROFIDP_IrqTask: CON/IND buffer full, record lost\n"));
+								llHdl->con_ind_overflows++;
+							}
+						}
+						else if ( stored ) {
 							if ((OSS_SemSignal( llHdl->osHdl, llHdl->con_buf_semP )) != 0) {
 								DBGWRT_ERR((DBH," *** PROFIDP_Init: Error signaling CON/IND buffer semaphore\n"));
 								return 1;
@@ -2040,8 +3159,8 @@ static int PROFIDP_IsrTask(LL_HANDLE *llHdl)
 
 							if ( diagStruct->rem_add < (DP_MAX_NUMBER_SLAVES + 1)
 								 && !diagStruct->status ) {
-								OSS_MemCopy(llHdl->osHdl, TWISTWORD(diagStruct->diag_data_len), (char*) diagData,
-											(char*) (&llHdl->chDiag[diagStruct->rem_add][0]));
+								dp_diag_update( llHdl, diagStruct->rem_add, (u_int8*) diagData,
+												TWISTWORD(diagStruct->diag_data_len) );
 
 								/* send signal for diag updated if installed */
 								if ( llHdl->sigHdl != NULL  ) {
@@ -2059,8 +3178,6 @@ static int PROFIDP_IsrTask(LL_HANDLE *llHdl)
 
 							/* clear flag getSlaveDiagReqWaitCon */
 							llHdl->getSlaveDiagReqWaitCon = FALSE;
-							/* clear flag fwAliveCheckWait */
-							llHdl->fwAliveCheckWait = FALSE;
 
 							/*
 							 * If more diags pending, trigger a DP_GET_SLAVE_DIAG REQ so
@@ -2124,10 +3241,11 @@ static int PROFIDP_IsrTask(LL_HANDLE *llHdl)
 		if ( irqVal == 0x0f || irqVal == 0xf0 ) {
 			llHdl->irqCount++;  /* increase IRQ counter */
 			/* notify Profibus module that int was received */
-			DP_WRITE_INT8(llHdl->ma, COFF(H_ID), 0);
-			/* restore window pointer */
-			DP_SET_WINDOW(llHdl->ma, llHdl->current_wptr);
+			SET_WINDOW(llHdl->ma, COMM_OFF);
+			MWRITE_D8( llHdl->ma, H_ID, 0 );
 		}
+		/* restore window pointer */
+		SET_WINDOW(llHdl->ma, llHdl->current_wptr);
 
 		if( ERROR == semGive( llHdl->windowPointerSemId ) ) {
 			DBGWRT_ERR((DBH," >>> PROFIDP_IrqTask: Error giving window pointer semaphore\n"));
@@ -2142,65 +3260,537 @@ static int PROFIDP_IsrTask(LL_HANDLE *llHdl)
 	} /* while */
 }
 
-/****************************** PROFIDP_Info ************************************
- *
- *  Description:  Get information about hardware and driver requirements
- *
- *                The following info codes are supported:
+/**************************** PROFIDP_SnapTask *********************************
  *
- *                Code                      Description
- *                ------------------------  -----------------------------
- *                LL_INFO_HW_CHARACTER      hardware characteristics
- *                LL_INFO_ADDRSPACE_COUNT   nr of required address spaces
- *                LL_INFO_ADDRSPACE         address space information
- *                LL_INFO_IRQ               interrupt required
- *                LL_INFO_LOCKMODE          process lock mode required
+ *  Description:  Input snapshot task
  *
- *                The LL_INFO_HW_CHARACTER code returns all address and
- *                data modes (ORed) which are supported by the hardware
- *                (MDIS_MAxx, MDIS_MDxx).
+ *                Copies the input area of the process image periodically
+ *                into the host double buffer. The buffer not published is
+ *                written, then snapSeq is incremented to publish it.
+ *                The task waits on snapSemP while the snapshot is off.
  *
- *                The LL_INFO_ADDRSPACE_COUNT code returns the number
- *                of address spaces used by the driver.
+ *                Each snapshot is taken with the device semaphore held,
+ *                like the driver calls (LL_LOCK_CALL). So the DPRAM
+ *                window and the snapshot buffer are not changed by a
+ *                driver call meanwhile.
  *
- *                The LL_INFO_ADDRSPACE code returns information about one
- *                specific address space (MDIS_MAxx, MDIS_MDxx). The returned
- *                data mode represents the widest hardware access used by
- *                the driver.
+ *---------------------------------------------------------------------------
+ *  Input......:  llHdl    low-level handle
+ *  Output.....:  return   void
+ *  Globals....:  ---
+ ****************************************************************************/
+static int PROFIDP_SnapTask(LL_HANDLE *llHdl)
+{
+	u_int16 dataSize;
+	u_int8  *buf;
+
+	while( 1 ){
+		if( !llHdl->snapPeriod || !llHdl->snapSize ) {
+			llHdl->snapValid = 0;
+			OSS_SemWait( llHdl->osHdl, llHdl->snapSemP, OSS_SEM_WAITFOREVER );
+			continue;
+		}
+
+		OSS_Delay( llHdl->osHdl, (int32) llHdl->snapPeriod );
+
+		taskSafe();
+		OSS_SemWait( llHdl->osHdl, llHdl->devSemP, OSS_SEM_WAITFOREVER );
+
+		/* snapshot may be switched off or reallocated meanwhile */
+		if( llHdl->snapPeriod && llHdl->snapSize ) {
+			dataSize = (u_int16) llHdl->snapSize;
+			buf = llHdl->snapBuf + (((llHdl->snapSeq + 1) & 1) * llHdl->snapSize);
+
+			if( profi_get_data( llHdl, ID_DP_SLAVE_IO_IMAGE, (USIGN16) 0,
+								&dataSize, buf ) != E_OK ) {
+				DBGWRT_ERR((DBH, " *** PROFIDP_SnapTask: get data failed\n"));
+			}
+			else {
+				/* compare with last snapshot */
+				if( llHdl->snapValid )
+					PROFIDP_chgDetect( llHdl, llHdl->snapBuf +
+									   ((llHdl->snapSeq & 1) * llHdl->snapSize), buf );
+
+				llHdl->snapTick = ACT_TICK;
+				llHdl->snapSeq++;		/* publish buffer */
+				llHdl->snapValid = 1;
+			}
+		}
+
+		OSS_SemSignal( llHdl->osHdl, llHdl->devSemP );
+		taskUnsafe();
+	}
+
+	return 0;
+}
+
+/**************************** PROFIDP_snapRead **********************************
  *
- *                The LL_INFO_IRQ code returns whether the driver supports an
- *                interrupt routine (TRUE or FALSE).
+ *  Description:  Read from input snapshot
  *
- *                The LL_INFO_LOCKMODE code returns which process locking
- *                mode the driver needs (LL_LOCK_xxx).
+ *                Copies data from the published snapshot buffer. Called
+ *                with the device semaphore held, so the snapshot task
+ *                can't publish a new buffer meanwhile.
  *
  *---------------------------------------------------------------------------
- *  Input......:  infoType	   info code
- *                ...          argument(s)
- *  Output.....:  return       success (0) or error code
+ *  Input......:  llHdl    low-level handle
+ *                offs     offset in input area
+ *                sizeP    nbr of bytes to read
+ *                buf      user buffer
+ *  Output.....:  sizeP    nbr of read bytes
+ *                return   0=read from snapshot, -1=no snapshot available
  *  Globals....:  ---
  ****************************************************************************/
-static int32 PROFIDP_Info(
-   int32  infoType,
-   ...
-)
+static int32 PROFIDP_snapRead(LL_HANDLE *llHdl, u_int32 offs, u_int16 *sizeP, u_int8 *buf)
 {
-    int32   error = ERR_SUCCESS;
-    va_list argptr;
+	if( !llHdl->snapPeriod || !llHdl->snapValid || offs >= llHdl->snapSize )
+		return -1;
 
-    va_start(argptr, infoType );
+	/* limit to size of input area */
+	if( offs + *sizeP > llHdl->snapSize )
+		*sizeP = (u_int16) (llHdl->snapSize - offs);
 
-    switch(infoType) {
-		/*-------------------------------+
-        |  hardware characteristics      |
-        |  (all addr/data modes ORed)    |
-        +-------------------------------*/
-        case LL_INFO_HW_CHARACTER:
-		{
-			u_int32 *addrModeP = va_arg(argptr, u_int32*);
+	OSS_MemCopy( llHdl->osHdl, *sizeP,
+				 (char*) llHdl->snapBuf + ((llHdl->snapSeq & 1) * llHdl->snapSize) + offs,
+				 (char*) buf );
+
+	return 0;
+}
+
+/**************************** PROFIDP_snapAlloc *********************************
+ *
+ *  Description:  (Re)allocate input snapshot double buffer
+ *
+ *                The buffer is sized for the input area of the current
+ *                configuration. A buffer too small is freed and
+ *                allocated again. Called with the device semaphore
+ *                held, so the snapshot task doesn't use the buffer.
+ *
+ *---------------------------------------------------------------------------
+ *  Input......:  llHdl    low-level handle
+ *  Output.....:  return   success (0) or error code
+ *  Globals....:  ---
+ ****************************************************************************/
+static int32 PROFIDP_snapAlloc(LL_HANDLE *llHdl)
+{
+	u_int32 size = DP_OUT_POINTER;
+
+	llHdl->snapValid = 0;
+	llHdl->snapSize  = 0;
+	OSS_MemFill( llHdl->osHdl, sizeof(llHdl->chgBits), (char*) llHdl->chgBits, 0x00 );
+
+	if( llHdl->snapBuf && 2 * size > llHdl->snapMemSize ) {
+		OSS_MemFree( llHdl->osHdl, llHdl->snapBuf, llHdl->snapMemSize );
+		llHdl->snapBuf = NULL;
+	}
+	if( llHdl->snapBuf == NULL && size ) {
+		llHdl->snapBuf = (u_int8*) OSS_MemGet( llHdl->osHdl, 2 * size,
+											   &llHdl->snapMemSize );
+		if( llHdl->snapBuf == NULL ) {
+			DBGWRT_ERR((DBH, " *** PROFIDP_snapAlloc: can't alloc snapshot buffer\n"));
+			return (ERR_OSS_MEM_ALLOC);
+		}
+	}
+
+	llHdl->snapSize = size;
+	OSS_SemSignal( llHdl->osHdl, llHdl->snapSemP );
+	return (ERR_SUCCESS);
+}
+
+/**************************** PROFIDP_liveList **********************************
+ *
+ *  Description:  Build live list from DP status image
+ *
+ *                One data descriptor access, no service request.
+ *                pb_if.h doesn't document the layout of the status image
+ *                and it holds no data transfer list. It is read as one
+ *                station status byte per address (DP_STATUS_INFO_LEN,
+ *                DP_STATE_xxx bits of pb_dp.h). A configured slave
+ *                station without DP_STATE_SLAVE_ERROR counts as in data
+ *                exchange, only while the stack is in OPERATE.
+ *                The generation is incremented when the result differs
+ *                from the last call.
+ *
+ *---------------------------------------------------------------------------
+ *  Input......:  llHdl    low-level handle
+ *                ll       live list to fill
+ *  Output.....:  return   0 or error code
+ *  Globals....:  ---
+ ****************************************************************************/
+static int32 PROFIDP_liveList(LL_HANDLE *llHdl, PROFIDP_LIVE_LIST *ll)
+{
+	u_int8  state[DP_STATUS_INFO_LEN];
+	u_int16 dataSize = DP_STATUS_INFO_LEN;
+	u_int32 live[DP_CHG_WORDS], diag[DP_CHG_WORDS];
+	u_int32 i, chg = 0;
+	u_int8  operate = (llHdl->stackState == DP_ST_OPERATE);
+
+	if( profi_get_data( llHdl, ID_DP_STATUS_IMAGE, (USIGN16) 0, &dataSize,
+						state ) != E_OK || dataSize < DP_MAX_NUMBER_SLAVES ) {
+		DBGWRT_ERR((DBH, " *** PROFIDP_liveList: get status image failed\n"));
+		return (PROFIDP_ERR_GET_DATA);
+	}
+
+	OSS_MemFill( llHdl->osHdl, sizeof(live), (char*) live, 0x00 );
+	OSS_MemFill( llHdl->osHdl, sizeof(diag), (char*) diag, 0x00 );
+
+	for( i = 0; i < dataSize && i < 32 * DP_CHG_WORDS; i++ ){
+		if( (state[i] & DP_STATE_STATION_TYPE) != DP_STATE_SLAVE_STATION )
+			continue;
+		if( state[i] & DP_STATE_SLAVE_DIAG_DATA )
+			diag[i / 32] |= 1UL << (i % 32);
+		if( operate && i < DP_MAX_NUMBER_SLAVES && llHdl->cfgIdx[i].offs &&
+			!(state[i] & DP_STATE_SLAVE_ERROR) )
+			live[i / 32] |= 1UL << (i % 32);
+	}
+
+	for( i = 0; i < DP_CHG_WORDS; i++ ){
+		chg |= (live[i] ^ llHdl->liveBits[i]) | (diag[i] ^ llHdl->liveDiag[i]);
+		llHdl->liveBits[i] = live[i];
+		llHdl->liveDiag[i] = diag[i];
+	}
+	if( chg )
+		llHdl->liveGen++;
+
+	ll->gen = llHdl->liveGen;
+	for( i = 0; i < PROFIDP_CHANGED_SIZE; i++ ){
+		ll->live[i] = (u_int8) (live[i / 4] >> ((i % 4) * 8));
+		ll->diag[i] = (u_int8) (diag[i / 4] >> ((i % 4) * 8));
+	}
+
+	return 0;
+}
+
+/**************************** PROFIDP_chgDetect *********************************
+ *
+ *  Description:  Detect changed inputs between two snapshots
+ *
+ *                Compares the input data of each configured slave and sets
+ *                its bit in the change bitmap. The installed signal is sent
+ *                once per snapshot if PROFIDP_SIG_ON_CHANGE is set and a
+ *                slave changed.
+ *
+ *---------------------------------------------------------------------------
+ *  Input......:  llHdl    low-level handle
+ *                oldBuf   last snapshot
+ *                newBuf   new snapshot
+ *  Output.....:  -
+ *  Globals....:  ---
+ ****************************************************************************/
+static void PROFIDP_chgDetect(LL_HANDLE *llHdl, u_int8 *oldBuf, u_int8 *newBuf)
+{
+	u_int32 ch, offs, i;
+	u_int32 chg[DP_CHG_WORDS];
+	u_int8  any = 0;
+
+	OSS_MemFill( llHdl->osHdl, sizeof(chg), (char*) chg, 0x00 );
+
+	for( ch = llHdl->lowest_slave_address;
+		 ch < (llHdl->lowest_slave_address + llHdl->maxNumSlaves) &&
+		 ch < DP_MAX_NUMBER_SLAVES; ch++ ){
+		if( !llHdl->chInfo[ch].num_in )
+			continue;
+
+		offs = DP_ARRAY_OFFSET_IN(ch);
+		for( i = 0; i < llHdl->chInfo[ch].num_in; i++ ){
+			if( oldBuf[offs + i] != newBuf[offs + i] ) {
+				chg[ch / 32] |= 1UL << (ch % 32);
+				any = 1;
+				break;
+			}
+		}
+	}
+
+	if( !any )
+		return;
+
+	OSS_SemWait( llHdl->osHdl, llHdl->chgSemP, OSS_SEM_WAITFOREVER );
+	for( i = 0; i < DP_CHG_WORDS; i++ )
+		llHdl->chgBits[i] |= chg[i];
+	OSS_SemSignal( llHdl->osHdl, llHdl->chgSemP );
+
+	if( llHdl->chgSig && llHdl->sigHdl != NULL )
+		OSS_SigSend( llHdl->osHdl, llHdl->sigHdl );
+}
+
+/**************************** PROFIDP_FlushTask ********************************
+ *
+ *  Description:  Output shadow flush task
+ *
+ *                Writes the dirty ranges of the output shadow periodically
+ *                to the DPRAM. The task waits on flushSemP while the output
+ *                shadow is off.
+ *
+ *                The flush is done with the device semaphore held, see
+ *                PROFIDP_SnapTask.
+ *
+ *---------------------------------------------------------------------------
+ *  Input......:  llHdl    low-level handle
+ *  Output.....:  return   void
+ *  Globals....:  ---
+ ****************************************************************************/
+static int PROFIDP_FlushTask(LL_HANDLE *llHdl)
+{
+	while( 1 ){
+		if( !llHdl->flushPeriod || !llHdl->outShadow ) {
+			OSS_SemWait( llHdl->osHdl, llHdl->flushSemP, OSS_SEM_WAITFOREVER );
+			continue;
+		}
+
+		OSS_Delay( llHdl->osHdl, (int32) llHdl->flushPeriod );
+
+		taskSafe();
+		OSS_SemWait( llHdl->osHdl, llHdl->devSemP, OSS_SEM_WAITFOREVER );
+
+		if( llHdl->flushPeriod && PROFIDP_flushOutputs( llHdl ) ) {
+			DBGWRT_ERR((DBH, " *** PROFIDP_FlushTask: flush failed\n"));
+		}
+
+		OSS_SemSignal( llHdl->osHdl, llHdl->devSemP );
+		taskUnsafe();
+	}
+
+	return 0;
+}
+
+/**************************** PROFIDP_SubmitTask *******************************
+ *
+ *  Description:  Submission task
+ *
+ *                Sends the requests queued by PROFIDP_asyncSubmit() in
+ *                order. The ACK is awaited here, the CON is put into the
+ *                completion queue by the ISR-Task. A response or a
+ *                request which could not be sent completes immediately.
+ *                At least every second, requests without CON after
+ *                DP_ASYNC_TIMEOUT are completed with a timeout error.
+ *                Runs task safe while it holds the window pointer
+ *                semaphore or waits for the ACK.
+ *
+ *---------------------------------------------------------------------------
+ *  Input......:  llHdl    low-level handle
+ *  Output.....:  return   void
+ *  Globals....:  ---
+ ****************************************************************************/
+static int PROFIDP_SubmitTask(LL_HANDLE *llHdl)
+{
+	T_PROFI_SERVICE_DESCR psd;
+	PEND_REQ *req;
+	int16 dpError;
+
+	while( 1 ){
+		OSS_SemWait( llHdl->osHdl, llHdl->sqSemP, 1000 );
+
+		if (0 != taskSafe ()) {
+			perror ("taskSafe");
+			return 1;
+		}
+
+		semTake( llHdl->windowPointerSemId, WAIT_FOREVER );
+		PROFIDP_asyncExpire( llHdl );
+		if( llHdl->sqOut == llHdl->sqIn ) {
+			semGive( llHdl->windowPointerSemId );
+			taskUnsafe ();
+			continue;
+		}
+		req = &llHdl->pendReq[llHdl->sq[llHdl->sqOut++ % DP_MAX_PEND_REQ]];
+		psd = req->sdb;
+		psd.invoke_id = req->invoke_id;
+		req->sent     = (psd.primitive == REQ);
+		req->sentTick = ACT_TICK;
+		semGive( llHdl->windowPointerSemId );
+
+		/* REQ data is in conBuf until the CON arrives */
+		dpError = profi_snd_req_res_usr( llHdl, &psd, req->conBuf );
+
+		if( dpError != E_OK || psd.primitive != REQ ) {
+			if( dpError != E_OK ) {
+				DBGWRT_ERR((DBH, " *** PROFIDP_SubmitTask: error %04x sending tag 0x%x\n",
+							dpError, req->tag));
+			}
+
+			semTake( llHdl->windowPointerSemId, WAIT_FOREVER );
+			if( !req->done ) {
+				req->conLen = 0;
+				PROFIDP_asyncDone( llHdl, req,
+								   dpError != E_OK ? PROFIDP_ERR_SEND_REQ_RES : ERR_SUCCESS );
+			}
+			semGive( llHdl->windowPointerSemId );
+		}
+
+		if (0 != taskUnsafe ()) {
+			perror ("taskUnsafe");
+			return 1;
+		}
+	}
+
+	return 0;
+}
+
+/************************** PROFIDP_outShadowWrite ******************************
+ *
+ *  Description:  Write data to output shadow and mark it dirty
+ *
+ *                The dirty range is tracked per slave slot of the output
+ *                area (see DP_ARRAY_OFFSET_OUT).
+ *
+ *---------------------------------------------------------------------------
+ *  Input......:  llHdl    low-level handle
+ *                offs     offset in output area
+ *                len      nbr of bytes
+ *                buf      data
+ *  Output.....:  -
+ *  Globals....:  ---
+ ****************************************************************************/
+static void PROFIDP_outShadowWrite(LL_HANDLE *llHdl, u_int32 offs, u_int32 len, u_int8 *buf)
+{
+	u_int32 stride = llHdl->max_slave_output_len;
+	u_int32 end    = offs + len;
+	u_int32 slot, lo, hi;
+
+	OSS_SemWait( llHdl->osHdl, llHdl->outShadowSemP, OSS_SEM_WAITFOREVER );
+
+	OSS_MemCopy( llHdl->osHdl, len, (char*) buf, (char*) llHdl->outShadow + offs );
+
+	while( offs < end ){
+		slot = offs / stride;
+		lo   = offs - (slot * stride);
+		hi   = end - (slot * stride);
+		if( hi > stride )
+			hi = stride;
+
+		if( llHdl->outDirty[slot].hi == 0 ) {
+			llHdl->outDirty[slot].lo = (u_int8) lo;
+			llHdl->outDirty[slot].hi = (u_int8) hi;
+		}
+		else {
+			if( lo < llHdl->outDirty[slot].lo )
+				llHdl->outDirty[slot].lo = (u_int8) lo;
+			if( hi > llHdl->outDirty[slot].hi )
+				llHdl->outDirty[slot].hi = (u_int8) hi;
+		}
+		offs = (slot * stride) + hi;
+	}
+	llHdl->outDirtyAny = 1;
+
+	OSS_SemSignal( llHdl->osHdl, llHdl->outShadowSemP );
+}
+
+/*************************** PROFIDP_flushOutputs *******************************
+ *
+ *  Description:  Write dirty ranges of output shadow to DPRAM
+ *
+ *                All dirty ranges are written while the host semaphore
+ *                of the process image is held (allCh).
+ *
+ *---------------------------------------------------------------------------
+ *  Input......:  llHdl    low-level handle
+ *  Output.....:  return   success (0) or error code
+ *  Globals....:  ---
+ ****************************************************************************/
+static int32 PROFIDP_flushOutputs(LL_HANDLE *llHdl)
+{
+	u_int32 stride = llHdl->max_slave_output_len;
+	u_int32 slot, offs;
+	int32   error = ERR_SUCCESS;
+
+	if( !llHdl->outShadow || !llHdl->outDirtyAny )
+		return ERR_SUCCESS;
+
+	OSS_SemWait( llHdl->osHdl, llHdl->outShadowSemP, OSS_SEM_WAITFOREVER );
+
+	llHdl->allCh = 1;
+
+	for( slot = 0; slot < llHdl->maxNumSlaves && slot < DP_MAX_NUMBER_SLAVES; slot++ ){
+		if( llHdl->outDirty[slot].hi == 0 )
+			continue;
+
+		offs = (slot * stride) + llHdl->outDirty[slot].lo;
+
+		if( profi_set_data( llHdl, ID_DP_SLAVE_IO_IMAGE, (USIGN16) (DP_OUT_POINTER + offs),
+				(USIGN16) (llHdl->outDirty[slot].hi - llHdl->outDirty[slot].lo),
+				llHdl->outShadow + offs ) != E_OK ) {
+			DBGWRT_ERR((DBH, " *** PROFIDP_flushOutputs: set data slot %d failed\n", slot));
+			error = PROFIDP_ERR_SET_DATA;
+			break;
+		}
+		llHdl->outDirty[slot].hi = 0;
+	}
+
+	llHdl->allCh = 0;
+	cmi_release_data_descr( llHdl, ID_DP_SLAVE_IO_IMAGE );
+
+	if( !error )
+		llHdl->outDirtyAny = 0;
+
+	OSS_SemSignal( llHdl->osHdl, llHdl->outShadowSemP );
+
+	return error;
+}
+
+/****************************** PROFIDP_Info ************************************
+ *
+ *  Description:  Get information about hardware and driver requirements
+ *
+ *                The following info codes are supported:
+ *
+ *                Code                      Description
+ *                ------------------------  -----------------------------
+ *                LL_INFO_HW_CHARACTER      hardware characteristics
+ *                LL_INFO_ADDRSPACE_COUNT   nr of required address spaces
+ *                LL_INFO_ADDRSPACE         address space information
+ *                LL_INFO_IRQ               interrupt required
+ *                LL_INFO_LOCKMODE          process lock mode required
+ *
+ *                The LL_INFO_HW_CHARACTER code returns all address and
+ *                data modes (ORed) which are supported by the hardware
+ *                (MDIS_MAxx, MDIS_MDxx).
+ *
+ *                The LL_INFO_ADDRSPACE_COUNT code returns the number
+ *                of address spaces used by the driver.
+ *                Address space 0 (A08) holds the registers and the
+ *                DPRAM window, address space 1 (A24) maps the DPRAM
+ *                directly and is only used if DPRAM_DIRECT is set.
+ *                Address space 1 is only requested if the driver is
+ *                built with switch PROFIDP_A24.
+ *
+ *                The LL_INFO_ADDRSPACE code returns information about one
+ *                specific address space (MDIS_MAxx, MDIS_MDxx). The returned
+ *                data mode represents the widest hardware access used by
+ *                the driver.
+ *
+ *                The LL_INFO_IRQ code returns whether the driver supports an
+ *                interrupt routine (TRUE or FALSE).
+ *
+ *                The LL_INFO_LOCKMODE code returns which process locking
+ *                mode the driver needs (LL_LOCK_xxx).
+ *
+ *---------------------------------------------------------------------------
+ *  Input......:  infoType	   info code
+ *                ...          argument(s)
+ *  Output.....:  return       success (0) or error code
+ *  Globals....:  ---
+ ****************************************************************************/
+static int32 PROFIDP_Info(
+   int32  infoType,
+   ...
+)
+{
+    int32   error = ERR_SUCCESS;
+    va_list argptr;
+
+    va_start(argptr, infoType );
+
+    switch(infoType) {
+		/*-------------------------------+
+        |  hardware characteristics      |
+        |  (all addr/data modes ORed)    |
+        +-------------------------------*/
+        case LL_INFO_HW_CHARACTER:
+		{
+			u_int32 *addrModeP = va_arg(argptr, u_int32*);
 			u_int32 *dataModeP = va_arg(argptr, u_int32*);
 
-			*addrModeP = MDIS_MA08;
+			*addrModeP = MDIS_MA08 | MDIS_MA24;
 			*dataModeP = MDIS_MD08 | MDIS_MD16;
 			break;
 	    }
@@ -2228,11 +3818,18 @@ static int32 PROFIDP_Info(
 
 			if (addrSpaceIndex >= ADDRSPACE_COUNT)
 				error = ERR_LL_ILL_PARAM;
-			else {
+			else if (addrSpaceIndex == 0) {
+				/* registers and A08 DPRAM window */
 				*addrModeP = MDIS_MA08;
 				*dataModeP = MDIS_MD16;
 				*addrSizeP = ADDRSPACE_SIZE;
 			}
+			else {
+				/* DPRAM, directly mapped */
+				*addrModeP = MDIS_MA24;
+				*dataModeP = MDIS_MD16;
+				*addrSizeP = ADDRSPACE_SIZE_A24;
+			}
 
 			break;
 	    }
@@ -2302,132 +3899,194 @@ static int16 PROFIDP_Config ( LL_HANDLE* llHdl, M_SG_BLOCK *blk ) /* nodoc */
 	u_int8                      i;
 	u_int8*                     dummy_p;
 	int32                       retVal;
-	T_DP_BUS_PARA_SET*          buspar;
-	T_DP_SLAVE_PARA_SET*        slavepar;
 	u_int16                     con_status;
 	USIGN16                     max_bus_para_len;
 	USIGN16                     max_slave_para_len;
 	STRINGV*					master_class2_name_adr;
-	u_int16                     sl_para_len;
-	u_int8                      sl_addr;
-	u_int8*                     next_sl_add;
+	CFG_SLAVE*                  cs;
+	M57_PCFG_HDR*               pcfg;
+	u_int32                     pos;
 	u_int8                      sl_count;
-	u_int8                      num_in;
-	u_int8                      num_out;
 	T_DP_DOWNLOAD_REQ*          dl;  /* bus para set */
 	u_int8                      slave; /* slave para set */
 	u_int16                     new_data_len; /* buffer for new download data len */
-
-
-	DBGWRT_1((DBH, "LL - PROFIDP_Config: Start Firmware \n"));
-
-	/* set autostart address to firmware start address */
-	DP_WRITE_INT32(llHdl->ma, (u_int32) DP_AUTO_START_ADDR_POINTER, (u_int32) DP_AUTO_START_ADDR);
-
-	/* Initialize CMI interface */
-	DBGWRT_1((DBH, "LL - PROFIDP_Config: Start CMI-Initialization\n"));
-	retVal = (int16) profi_init(llHdl);
-
-	switch (retVal) {
-		case E_IF_NO_CNTRL_RES:
-			DBGWRT_1((DBH, "LL - PROFIDP_Config: No controller respons\n"));
+	u_int32                     t, tConfig;
+	u_int32                     hash;
+
+
+	/* startup times of this configuration */
+	tConfig = dp_time_us( llHdl );
+	for ( i = DP_T_CMI_READY; i <= DP_T_CONFIG; i++ )
+		llHdl->tPhase[i] = 0;
+	OSS_MemFill( llHdl->osHdl, sizeof(llHdl->tSlaveDl), (char*) llHdl->tSlaveDl, 0x00 );
+
+	/* check config data and build slave index before touching the hardware */
+	pcfg = (M57_PCFG_HDR*) blk->data;
+	if ( blk->size >= (int32) sizeof(*pcfg) &&
+		 TWISTLONG(pcfg->magic) == M57_PCFG_MAGIC ) {
+		/* precompiled configuration, see m57pcfg.h */
+		if ( dp_pcfg_check( llHdl, (u_int8*) blk->data, (u_int32) blk->size,
+							llHdl->cfgIdxNew ) < 0 ) {
+			DBGWRT_ERR((DBH, " *** LL - PROFIDP_Config: invalid precompiled configuration\n"));
 			return -1;
-
-		case E_OK:
-			DBGWRT_1((DBH, "LL - PROFIDP_Config: CMI configuration ok!\n"));
-
-		break;
-
-		default:
-			DBGWRT_1((DBH, "LL - PROFIDP_Config: Unknown ERROR occured\n"));
+		}
+		OSS_MemCopy( llHdl->osHdl, sizeof(llHdl->cfgIdx), (char*) llHdl->cfgIdxNew,
+					 (char*) llHdl->cfgIdx );
+	}
+	else {
+		pcfg = NULL;
+		if ( dp_bincfg_index( llHdl, (u_int8*) blk->data, (u_int32) blk->size,
+							  llHdl->cfgIdxNew ) < 0 ) {
+			DBGWRT_ERR((DBH, " *** LL - PROFIDP_Config: invalid configuration data\n"));
 			return -1;
+		}
+		OSS_MemCopy( llHdl->osHdl, sizeof(llHdl->cfgIdx), (char*) llHdl->cfgIdxNew,
+					 (char*) llHdl->cfgIdx );
 	}
 
-	max_bus_para_len = TWISTWORD(*(u_int16*)blk->data); /* TWISTWORD(*(u_int16*)DP_konfig); */
-	DBGWRT_1((DBH, "LL - PROFIDP_Config: max_bus_para_len = %04x\n", max_bus_para_len));
-
-	/* extract master default address from config data (fdl_add) */
-	llHdl->master_default_address = *((u_int8*) blk->data + 2);   /* DP_konfig[3]; */
-	DBGWRT_1((DBH, "LL - PROFIDP_Config: master_default_address = %02x\n", llHdl->master_default_address));
+	if ( pcfg ) {
+		/* all values precomputed by m57_cfgpack */
+		max_bus_para_len = TWISTWORD(pcfg->maxBusParaLen);
+		max_slave_para_len = TWISTWORD(pcfg->maxSlaveParaLen);
+		llHdl->master_default_address = pcfg->masterAddr;
+		master_class2_name_adr = (STRINGV*) pcfg->masterClass2Name;
+		llHdl->max_slave_input_len = pcfg->maxInLen;
+		llHdl->max_slave_output_len = pcfg->maxOutLen;
+		if (llHdl->lowest_slave_address == 0xff)
+			llHdl->lowest_slave_address = pcfg->lowestSlAddr;
+		for ( i = 0; i < DP_MAX_NUMBER_SLAVES; i++ ) {
+			llHdl->chInfo[i].num_in = pcfg->chInfo[i][0];
+			llHdl->chInfo[i].num_out = pcfg->chInfo[i][1];
+		}
+		DBGWRT_2((DBH, "LL - PROFIDP_Config: precompiled, hash = %08x\n",
+					   TWISTLONG(pcfg->hash)));
+	}
+	else {
+		max_bus_para_len = DP_CFG_WORD((u_int8*) blk->data);
+		DBGWRT_1((DBH, "LL - PROFIDP_Config: max_bus_para_len = %04x\n", max_bus_para_len));
 
-	/* extract master_class2_name from config data */
-	master_class2_name_adr = (STRINGV*) (((u_int8*) blk->data) + 34);
+		/* extract master default address from config data (fdl_add) */
+		llHdl->master_default_address = *((u_int8*) blk->data + 2);   /* DP_konfig[3]; */
+		DBGWRT_1((DBH, "LL - PROFIDP_Config: master_default_address = %02x\n", llHdl->master_default_address));
 
-	/* extract slave affecting data out of config data */
-	next_sl_add = (((u_int8*) blk->data) + 0x42);  /* (DP_konfig +0x42); */
-	DBGWRT_2((DBH, "LL - PROFIDP_Config get offs: next_sl_add (rel. to array start) = %04x\n",
-    	            (next_sl_add - ((u_int8*) blk->data))));
+		/* extract master_class2_name from config data */
+		master_class2_name_adr = (STRINGV*) (((u_int8*) blk->data) + 34);
 
-	sl_count = 0;
-	llHdl->max_slave_input_len = 0;
-	llHdl->max_slave_output_len = 0;
-	max_slave_para_len = 0;
-	num_in = 0;
-	num_out = 0;
+		/* extract slave affecting data out of slave index */
+		sl_count = 0;
+		llHdl->max_slave_input_len = 0;
+		llHdl->max_slave_output_len = 0;
+		max_slave_para_len = 0;
 
-	do {
+		for ( i = 0; i < DP_MAX_NUMBER_SLAVES; i++ ) {
+			cs = &llHdl->cfgIdx[i];
 
-		next_sl_add = get_offs(llHdl, next_sl_add, &sl_addr, &num_in, &num_out, &sl_para_len);
+			/* fill chInfo sturcture for current slave (0 if not configured) */
+			llHdl->chInfo[i].num_in = cs->num_in;
+			llHdl->chInfo[i].num_out = cs->num_out;
 
-		/* get lowest slave address */
-		if (sl_count == 0 && llHdl->lowest_slave_address == 0xff)
-			llHdl->lowest_slave_address = sl_addr;
+			if ( cs->offs == 0 )
+				continue;
 
-		/* fill chInfo sturcture for current slave */
-		llHdl->chInfo[sl_addr].num_in = num_in;
-		llHdl->chInfo[sl_addr].num_out = num_out;
+			/* get lowest slave address */
+			if (sl_count == 0 && llHdl->lowest_slave_address == 0xff)
+				llHdl->lowest_slave_address = i;
 
+			/* get max slave input length */
+			if ( cs->num_in > llHdl->max_slave_input_len)
+				llHdl->max_slave_input_len = cs->num_in;
 
-		/* get max slave input length */
-		if ( num_in > llHdl->max_slave_input_len)
-			llHdl->max_slave_input_len = num_in;
+			/* get max slave output length */
+			if ( cs->num_out > llHdl->max_slave_output_len)
+				llHdl->max_slave_output_len = cs->num_out;
 
-		/* get max slave output length */
-		if ( num_out > llHdl->max_slave_output_len)
-			llHdl->max_slave_output_len = num_out;
+			/* get max slave parameter length */
+			if (max_slave_para_len < cs->len)
+				max_slave_para_len = cs->len;
 
-		/* get max slave parameter length */
-		if (max_slave_para_len < sl_para_len)
-			max_slave_para_len = sl_para_len;
+			DBGWRT_2((DBH, "LL - PROFIDP_Config: sl_addr = %02x num_out = %08x"
+		    	           " num_in = %08x sl_data_len %04x\n",
+		        	       i, cs->num_out, cs->num_in, cs->len));
+			sl_count++;
+		}
 
 		DBGWRT_2((DBH, "LL - PROFIDP_Config: max_slave parameter lenght = %08x\n",
 		               max_slave_para_len));
-
 		DBGWRT_2((DBH, "LL - PROFIDP_Config: max_slave input lenght = %08x\n",
 		               llHdl->max_slave_input_len));
 		DBGWRT_2((DBH, "LL - PROFIDP_Config: max_slave output lenght = %08x\n",
 		               llHdl->max_slave_output_len));
+		DBGWRT_2((DBH, "LL - PROFIDP_Config: sl_count = %02x\n", sl_count));
 
-		DBGWRT_2((DBH, "LL - PROFIDP_Config: get offs: sl_addr = %02x num_out = %08x"
-	    	           " num_in = %08x sl_data_len %04x\n",
-	        	       sl_addr, num_out, num_in, sl_para_len));
-		DBGWRT_2((DBH, "LL - PROFIDP_Config get offs: next_sl_add (rel. to array start) = %04x\n",
-	    	            (next_sl_add - ((u_int8*) blk->data))));
-		sl_count++;
-	} while (next_sl_add < ( (u_int8*) (((u_int8*) blk->data) + blk->size) ));
+		max_slave_para_len += 4;  /* add possible alignment bytes which are added */
+		                          /* by function PROFIDP_copy_buspar */
+		if (max_slave_para_len > DP_MAX_DOWNLOAD_DATA_LEN)
+			max_slave_para_len = DP_MAX_DOWNLOAD_DATA_LEN;
 
-	DBGWRT_2((DBH, "LL - PROFIDP_Config get offs: sl_count = %02x\n", sl_count));
+		/* kp: max_slave_input_len/max_slave_output length must be word aligned */
 
-	/* clear memory-space for fmbSetConfig */
-	fmbSetConfig = (T_FMB_SET_CONFIGURATION_REQ *)llHdl->req_con_buf;
-	dummy_p = (u_int8*) fmbSetConfig;
-	for (i = 0; i < sizeof (*fmbSetConfig); i++) {
-		*dummy_p = 0;
-		dummy_p++;
+		if( llHdl->max_slave_output_len & 1 )
+			llHdl->max_slave_output_len++;
+		if( llHdl->max_slave_input_len & 1 )
+			llHdl->max_slave_input_len++;
 	}
 
-	max_slave_para_len += 4;  /* add possible alignment bytes which are added */
-	                          /* by function PROFIDP_copy_buspar */
-	if (max_slave_para_len > DP_MAX_DOWNLOAD_DATA_LEN)
-		max_slave_para_len = DP_MAX_DOWNLOAD_DATA_LEN;
+	/* hash of the configuration, see PROFIDP_CONFIG_HASH */
+	if ( pcfg )
+		hash = TWISTLONG(pcfg->hash);
+	else
+		hash = dp_crc32( 0xffffffff, (u_int8*) blk->data, (u_int32) blk->size );
 
-	/* kp: max_slave_input_len/max_slave_output length must be word aligned */
+	if ( llHdl->reattached && hash == llHdl->cfgHash ) {
+		/* firmware re-attached by PROFIDP_Init runs this configuration */
+		DBGWRT_1((DBH, "LL - PROFIDP_Config: firmware already configured, hash = %08x\n", hash));
+		llHdl->max_slave_para_len = max_slave_para_len;
+		goto download_done;
+	}
+	llHdl->reattached = 0;
+	llHdl->cfgHash    = 0;
+	llHdl->stackState = DP_ST_OFFLINE;
 
-	if( llHdl->max_slave_output_len & 1 )
-		llHdl->max_slave_output_len++;
-	if( llHdl->max_slave_input_len & 1 )
-		llHdl->max_slave_input_len++;
+	/* stop alive checking until the new firmware is configured */
+	semTake( llHdl->windowPointerSemId, WAIT_FOREVER );
+	llHdl->dataDescrValid = FALSE;
+	semGive( llHdl->windowPointerSemId );
 
+	DBGWRT_1((DBH, "LL - PROFIDP_Config: Start Firmware \n"));
+	llHdl->max_slave_para_len = 0;
+
+	/* set autostart address to firmware start address */
+	llHdl->hw_wptr = DP_WPTR_INVALID;
+	DP_WRITE_INT32(llHdl->ma, (u_int32) DP_AUTO_START_ADDR_POINTER, (u_int32) DP_AUTO_START_ADDR);
+
+	/* Initialize CMI interface */
+	DBGWRT_1((DBH, "LL - PROFIDP_Config: Start CMI-Initialization\n"));
+	t = dp_time_us( llHdl );
+	retVal = (int16) profi_init(llHdl);
+	llHdl->tPhase[DP_T_CMI_INIT] = dp_time_us( llHdl ) - t;
+
+	switch (retVal) {
+		case E_IF_NO_CNTRL_RES:
+			DBGWRT_1((DBH, "LL - PROFIDP_Config: No controller respons\n"));
+			return -1;
+
+		case E_OK:
+			DBGWRT_1((DBH, "LL - PROFIDP_Config: CMI configuration ok!\n"));
+
+		break;
+
+		default:
+			DBGWRT_1((DBH, "LL - PROFIDP_Config: Unknown ERROR occured\n"));
+			return -1;
+	}
+
+	/* clear memory-space for fmbSetConfig */
+	fmbSetConfig = (T_FMB_SET_CONFIGURATION_REQ *)llHdl->req_con_buf;
+	dummy_p = (u_int8*) fmbSetConfig;
+	for (i = 0; i < sizeof (*fmbSetConfig); i++) {
+		*dummy_p = 0;
+		dummy_p++;
+	}
 
 	/* assigning values form configuration file array */
 	fmbSetConfig->dp_active 			    	= PB_TRUE;
@@ -2442,10 +4101,13 @@ static int16 PROFIDP_Config ( LL_HANDLE* llHdl, M_SG_BLOCK *blk ) /* nodoc */
 	fmbSetConfig->dp.max_slave_para_len  	= TWISTWORD(max_slave_para_len);
 
     DBGWRT_2((DBH, "LL - PROFIDP_SetStat: Issue FMB set configuration request\n"));
-	if ( (req_con ( llHdl, FMB, FMB_SET_CONFIGURATION, (u_int8*) fmbSetConfig, &con_status))) {
+	t = dp_time_us( llHdl );
+	if ( (req_con ( llHdl, FMB, FMB_SET_CONFIGURATION, (u_int8*) fmbSetConfig, &con_status, NULL))) {
 	    DBGWRT_ERR((DBH, " *** LL - PROFIDP_SetStat: req_con Error\n"));
 		goto abort;
 	}
+	llHdl->tPhase[DP_T_FMB_SET_CONFIG] = dp_time_us( llHdl ) - t;
+	llHdl->max_slave_para_len = max_slave_para_len;
 
 	/* Issue Init master */
 	dpInitMaster = (T_DP_INIT_MASTER_REQ *)llHdl->req_con_buf;
@@ -2461,35 +4123,58 @@ static int16 PROFIDP_Config ( LL_HANDLE* llHdl, M_SG_BLOCK *blk ) /* nodoc */
 	dpInitMaster->cyclic_data_transfer 	= (PB_BOOL) llHdl->cyclicDataTransfer;
 
     DBGWRT_2((DBH, "LL - PROFIDP_SetStat: Issue Init master request sizeof:\n"));
+	t = dp_time_us( llHdl );
 	if( (req_con( llHdl, DP, DP_INIT_MASTER,(u_int8 *)dpInitMaster,
-						&con_status )))													{
+						&con_status, NULL )))													{
 	    DBGWRT_ERR((DBH, " *** LL - PROFIDP_SetStat: req_con Error\n"));
 		goto abort;
 	}
+	llHdl->tPhase[DP_T_INIT_MASTER] = dp_time_us( llHdl ) - t;
 
 	/*------------------------+
     |  Load Busparameter Set  |
     +------------------------*/
 
-	dl = (T_DP_DOWNLOAD_REQ *) llHdl->req_con_buf;
-	/*--- get ptr to busparameter struct ---*/
-	if((buspar = dp_bincfg_get_buspar(llHdl, (u_int8*) blk->data, (u_int32) blk->size ))==NULL){
-		DBGWRT_ERR((DBH, "Can't find BUS PARAMETER struct!\n"));
-		goto abort;
+	if ( pcfg ) {
+		/* send prepared download requests as they are */
+		pos = TWISTWORD(pcfg->hdrLen);
+		for ( i = 0; i < pcfg->numDl; i++ ) {
+			dl = (T_DP_DOWNLOAD_REQ *) ((u_int8*) blk->data + pos);
+			DBGWRT_2((DBH, "LL - PROFIDP_Config: Loading area %d\n", dl->area_code));
+			slave = dl->area_code;
+
+			t = dp_time_us( llHdl );
+			if( (req_con( llHdl, DP, DP_DOWNLOAD_LOC, (u_int8 *)dl,
+						  &con_status, NULL )))
+				goto abort;
+			t = dp_time_us( llHdl ) - t;
+			if ( i == 0 )
+				llHdl->tPhase[DP_T_BUS_PARA_DL] = t;
+			else {
+				if ( slave < DP_MAX_NUMBER_SLAVES )
+					llHdl->tSlaveDl[slave] = t;
+				llHdl->tPhase[DP_T_SLAVE_PARA_DL] += t;
+			}
+			pos += (sizeof(*dl) + TWISTWORD(dl->data_len) + 1) & ~1;
+		}
+		goto download_done;
 	}
-	dl->data_len = buspar->bus_para_len;
+
+	dl = (T_DP_DOWNLOAD_REQ *) llHdl->req_con_buf;
+	dl->data_len = TWISTWORD(max_bus_para_len);
 	dl->rem_add  = llHdl->master_default_address; /* 0 */
 	dl->area_code = DP_AREA_BUS_PARAM;
 	dl->add_offset = TWISTWORD(0);
 
-
-	OSS_MemCopy( llHdl->osHdl, TWISTWORD(dl->data_len), (char*) buspar, (char*)(dl+1));
+	OSS_MemCopy( llHdl->osHdl, max_bus_para_len, (char*) blk->data, (char*)(dl+1));
 
 	DBGWRT_2((DBH, "LL - PROFIDP_SetStat: Loading bus parameter\n"));
 
+	t = dp_time_us( llHdl );
 	if( (req_con(llHdl, DP, DP_DOWNLOAD_LOC, (u_int8 *)dl,
-						  &con_status )))
+						  &con_status, NULL )))
 		goto abort;
+	llHdl->tPhase[DP_T_BUS_PARA_DL] = dp_time_us( llHdl ) - t;
 
 
 	/*-------------------------------+
@@ -2497,27 +4182,74 @@ static int16 PROFIDP_Config ( LL_HANDLE* llHdl, M_SG_BLOCK *blk ) /* nodoc */
     +-------------------------------*/
 
 
-	for( slave=0; slave<127; slave++ ){
+	for( slave=0; slave<DP_MAX_NUMBER_SLAVES; slave++ ){
+		cs = &llHdl->cfgIdx[slave];
+		if( cs->offs == 0 )
+			continue;
 
-		/*--- get ptr to slaveparameter struct ---*/
-		if((slavepar = dp_bincfg_get_slavepar( llHdl, (u_int8*) blk->data, (u_int32) blk->size, slave ))){
+		dl->rem_add  = llHdl->master_default_address; /* 0 */
+		dl->area_code = slave;
+		dl->add_offset = TWISTWORD(0);
 
-			dl->data_len = slavepar->slave_para_len;
-			dl->rem_add  = llHdl->master_default_address; /* 0 */
-			dl->area_code = slave;
-			dl->add_offset = TWISTWORD(0);
+		new_data_len = (u_int16) PROFIDP_copy_buspar(cs->len, (u_int8*) blk->data + cs->offs, (u_int8*)(dl+1));
+		dl->data_len = TWISTWORD(new_data_len);
+		DBGWRT_2((DBH, "Loading slave parameter set %d\n", slave));
 
-			new_data_len = (u_int16) PROFIDP_copy_buspar((u_int16) TWISTWORD(dl->data_len), (u_int8*) slavepar, (u_int8*)(dl+1));
-			dl->data_len = TWISTWORD(new_data_len);
-			DBGWRT_2((DBH, "Loading slave parameter set %d\n", slave));
+		t = dp_time_us( llHdl );
+		if( (req_con( llHdl/*mode*/, DP, DP_DOWNLOAD_LOC, (u_int8 *)dl,
+				  &con_status, NULL )))
+			goto abort;
+		llHdl->tSlaveDl[slave] = dp_time_us( llHdl ) - t;
+		llHdl->tPhase[DP_T_SLAVE_PARA_DL] += llHdl->tSlaveDl[slave];
+	}
 
-			if( (req_con( llHdl/*mode*/, DP, DP_DOWNLOAD_LOC, (u_int8 *)dl,
-					  &con_status )))
-				goto abort;
+download_done:
+	llHdl->cfgHash = hash;
+
+	/* data description list is static now, read it once */
+	cmi_read_data_descr_list( llHdl );
+
+	/* one diag entry per configured slave */
+	dp_diag_alloc( llHdl );
+
+	/* diag INDs before re-attach went to the previous instance */
+	if ( llHdl->reattached )
+		dp_diag_refetch( llHdl );
+
+	/* input snapshot double buffer for the new input area */
+	PROFIDP_snapAlloc( llHdl );
+
+	/* allocate output shadow (once) */
+	OSS_SemWait( llHdl->osHdl, llHdl->outShadowSemP, OSS_SEM_WAITFOREVER );
+	if ( llHdl->outShadow == NULL && llHdl->maxNumSlaves * llHdl->max_slave_output_len != 0 ) {
+		llHdl->outShadow = (u_int8*) OSS_MemGet( llHdl->osHdl,
+								llHdl->maxNumSlaves * llHdl->max_slave_output_len,
+								&llHdl->outShadowMemSize );
+		if ( llHdl->outShadow == NULL ) {
+			DBGWRT_ERR((DBH, " *** LL - PROFIDP_Config: can't alloc output shadow\n"));
 		}
 	}
+	if ( llHdl->outShadow &&
+		 llHdl->maxNumSlaves * llHdl->max_slave_output_len <= llHdl->outShadowMemSize ) {
+		llHdl->outShadowSize = llHdl->maxNumSlaves * llHdl->max_slave_output_len;
+		OSS_MemFill( llHdl->osHdl, llHdl->outShadowSize, (char*) llHdl->outShadow, 0x00 );
+		OSS_MemFill( llHdl->osHdl, sizeof(llHdl->outDirty), (char*) llHdl->outDirty, 0x00 );
+		llHdl->outDirtyAny = 0;
+	}
+	else if ( llHdl->outShadow ) {
+		/* output shadow to small, write through */
+		OSS_MemFree( llHdl->osHdl, llHdl->outShadow, llHdl->outShadowMemSize );
+		llHdl->outShadow     = NULL;
+		llHdl->outShadowSize = 0;
+	}
+	OSS_SemSignal( llHdl->osHdl, llHdl->outShadowSemP );
+	OSS_SemSignal( llHdl->osHdl, llHdl->flushSemP );
 
+	/* (re)start alive checking */
+	llHdl->fwAlive = TRUE;
+	OSS_SemSignal( llHdl->osHdl, llHdl->aliveSemP );
 
+	llHdl->tPhase[DP_T_CONFIG] = dp_time_us( llHdl ) - tConfig;
 	return (0);		/* configuration done and ok */
 	abort:
 	    DBGWRT_ERR((DBH, " *** LL - PROFIDP_SetStat: req_con Error doing abort condition\n"));
@@ -2526,94 +4258,530 @@ static int16 PROFIDP_Config ( LL_HANDLE* llHdl, M_SG_BLOCK *blk ) /* nodoc */
 
 }
 
-/************************* dp_bincfg_get_buspar ****************************
+/**************************** dp_bincfg_index ******************************
  *
- *  Description: Get pointer to Bus-Parameter data out of configuration array
+ *  Description: Check configuration data array and build slave index
+ *
+ *               Walks the configuration data once. The bus parameter set
+ *               and each slave parameter set (see dp_bincfg_slave) are
+ *               checked against the array size and the download buffer.
+ *               Up to 4 trailing bytes are ignored. For each slave,
+ *               idx[address] gets the offset and length of its
+ *               T_DP_SLAVE_PARA_SET, the download length and the nbr of
+ *               in/outputs. idx is not llHdl->cfgIdx, which is still used
+ *               by the running configuration if the data is rejected.
  *
  *---------------------------------------------------------------------------
  *  Input......: llHdl		low-level handle
  *               data_ptr   pointer to configuration data array
  *				 data_size  size of configuration data array
  *
- *  Output.....: return	    data_ptr if OK or NULL if data not valid
+ *  Output.....: idx        slave index (DP_MAX_NUMBER_SLAVES entries)
+ *               return	    0=ok, -1=data not valid
  *  Globals....: -
  ****************************************************************************/
 
-static T_DP_BUS_PARA_SET *dp_bincfg_get_buspar(LL_HANDLE* llHdl, u_int8* data_ptr, u_int32 data_size ) /* nodoc */
-
+static int32 dp_bincfg_index(LL_HANDLE* llHdl, u_int8* data_ptr, u_int32 data_size,
+                             CFG_SLAVE* idx ) /* nodoc */
 {
+	CFG_SLAVE *cs;
+	u_int32   pos, end;
+	u_int16   len;
+	u_int8    addr;
+	int32     sl_count = 0;
+
+	OSS_MemFill( llHdl->osHdl, DP_MAX_NUMBER_SLAVES * sizeof(*idx), (char*) idx, 0x00 );
+
+	/*--- bus parameter set ---*/
+	if( data_size < DP_CFG_BUS_PARA_MIN )
+		goto invalid;
+	len = DP_CFG_WORD(data_ptr);
+	if( len < DP_CFG_BUS_PARA_MIN || len > data_size || len > DP_CFG_MAX_DL_LEN ){
+		DBGWRT_ERR((DBH, " *** LL - dp_bincfg_index: bad bus_para_len %04x\n", len));
+		goto invalid;
+	}
 
-	if( data_size >= _skip_align( llHdl, data_ptr ))
-		return (T_DP_BUS_PARA_SET*) data_ptr;
-	else
-		return NULL;
+	/*--- slave parameter sets: address, T_DP_SLAVE_PARA_SET ---*/
+	for( pos = len; data_size - pos > 4; pos = end ){
+		addr = data_ptr[pos++];
+		len  = DP_CFG_WORD(data_ptr + pos);
+		end  = pos + len;   /* checked by dp_bincfg_slave() */
+
+		if( addr >= DP_MAX_NUMBER_SLAVES || idx[addr].offs ){
+			DBGWRT_ERR((DBH, " *** LL - dp_bincfg_index: bad/duplicate slave "
+						"address %d at %04x\n", addr, pos - 1));
+			goto invalid;
+		}
+		cs = &idx[addr];
+		if( dp_bincfg_slave( llHdl, data_ptr + pos, data_size - pos, addr, cs ) < 0 )
+			goto invalid;
+		cs->offs = pos;
+		sl_count++;
+
+		DBGWRT_2((DBH, "LL - dp_bincfg_index: slave %d: offs %04x len %04x "
+					"num_in %d num_out %d\n", addr, pos, len, cs->num_in, cs->num_out));
+	}
+
+	if( sl_count == 0 ){
+		DBGWRT_ERR((DBH, " *** LL - dp_bincfg_index: no slave configured\n"));
+		goto invalid;
+	}
+	return 0;
+
+invalid:
+	OSS_MemFill( llHdl->osHdl, DP_MAX_NUMBER_SLAVES * sizeof(*idx), (char*) idx, 0x00 );
+	return -1;
 }
 
-/************************ dp_bincfg_get_slavepar ****************************
+
+/**************************** dp_bincfg_slave ******************************
  *
- *  Description: Get pointer to Slave-Parameter data out of configuration array
+ *  Description: Check one slave parameter set
+ *
+ *               The prm, cfg, aat and user data blocks must exactly fill
+ *               slave_para_len. Alignment bytes inserted by
+ *               PROFIDP_copy_buspar must fit into the download buffer.
  *
  *---------------------------------------------------------------------------
  *  Input......: llHdl		    low-level handle
- *               data_ptr       pointer to configuration data array
- *				 data_size      size of configuration data array
- *               slave_address  address of slave
+ *               data_ptr       pointer to T_DP_SLAVE_PARA_SET
+ *				 data_size      nbr of bytes available at data_ptr
+ *               slave_address  address of slave (debug only)
  *
- *  Output.....: return	    data_ptr if OK or NULL if data not valid
+ *  Output.....: cs             len, dlLen, num_in and num_out set
+ *               return	        0=ok, -1=data not valid
  *  Globals....: -
  ****************************************************************************/
 
-static T_DP_SLAVE_PARA_SET *
- dp_bincfg_get_slavepar(LL_HANDLE* llHdl, u_int8* data_ptr, u_int32 data_size, u_int8 slave_address ) /* nodoc */
+static int32 dp_bincfg_slave(LL_HANDLE* llHdl, u_int8* data_ptr, u_int32 data_size,
+                             u_int8 slave_address, CFG_SLAVE* cs ) /* nodoc */
 {
-	u_int32 len,addr;
-
-	len = _skip_align( llHdl, data_ptr );        /* skip busparameters */
-	data_ptr += len;
-	data_size -= len;
+	u_int32   sub, subLen, len, dlLen;
+	u_int8    nSub = 0;
 
-	while( data_size > 4 ){
-		addr = *data_ptr++;			              /* slave address */
-		data_size--;
-		len = _skip_align( llHdl, data_ptr );     /* length of parameter set */
+	len = (data_size < 2) ? 0 : DP_CFG_WORD(data_ptr);
+	if( len < DP_CFG_SL_HDR_LEN || len > data_size || len > DP_CFG_MAX_DL_LEN ){
+		DBGWRT_ERR((DBH, " *** LL - dp_bincfg_slave: slave %d: bad "
+					"slave_para_len %04x\n", slave_address, len));
+		return -1;
+	}
 
-		if( addr == slave_address ){
-			if( data_size >= len )
-				return (T_DP_SLAVE_PARA_SET*) data_ptr;
-			else
-				return NULL;
+	/* prm, cfg, aat and user data, odd blocks are aligned for download */
+	dlLen       = len;
+	cs->num_in  = 0;
+	cs->num_out = 0;
+	for( sub = DP_CFG_SL_HDR_LEN; sub < len; sub += subLen ){
+		subLen = (len - sub < 2) ? 0 : DP_CFG_WORD(data_ptr + sub);
+		if( subLen < 2 || subLen > len - sub ){
+			DBGWRT_ERR((DBH, " *** LL - dp_bincfg_slave: slave %d: bad "
+						"data block length at %04x\n", slave_address, sub));
+			return -1;
+		}
+		if( nSub == 2 && subLen >= 4 ){    /* aat_data */
+			cs->num_in  = data_ptr[sub + 2];
+			cs->num_out = data_ptr[sub + 3];
 		}
-		data_ptr += len;
-		data_size -= len;
+		dlLen += subLen & 1;
+		nSub++;
 	}
-	return NULL;
+	if( nSub < 3 || dlLen > DP_CFG_MAX_DL_LEN ){
+		DBGWRT_ERR((DBH, " *** LL - dp_bincfg_slave: slave %d: bad "
+					"parameter set (%d blocks, %d bytes)\n", slave_address, nSub, dlLen));
+		return -1;
+	}
+
+	cs->len   = (u_int16) len;
+	cs->dlLen = (u_int16) dlLen;
+	return 0;
 }
 
-/***************************** _sikip_align *********************************
+/***************************** dp_pcfg_check *******************************
  *
- *  Description: Return size of following data structure
+ *  Description: Check precompiled configuration (see m57pcfg.h)
+ *
+ *               Only the layout is checked: header, size and the length
+ *               of each download block. The content was checked by
+ *               m57_cfgpack, the hash is not recalculated.
+ *               idx[address] gets the position and length of the slave
+ *               download blocks, it is used to find the configured
+ *               slaves only (see dp_bincfg_index).
  *
  *---------------------------------------------------------------------------
  *  Input......: llHdl		low-level handle
  *               data_ptr   pointer to configuration data array
+ *				 data_size  size of configuration data array
  *
- *  Output.....: return	    size (word aligned)
+ *  Output.....: idx        slave index (DP_MAX_NUMBER_SLAVES entries)
+ *               return	    0=ok, -1=data not valid
  *  Globals....: -
  ****************************************************************************/
 
-static u_int32 _skip_align(LL_HANDLE* llHdl, u_int8* data_ptr ) /* nodoc */
+static int32 dp_pcfg_check(LL_HANDLE* llHdl, u_int8* data_ptr, u_int32 data_size,
+                           CFG_SLAVE* idx ) /* nodoc */
+{
+	M57_PCFG_HDR      *pcfg = (M57_PCFG_HDR*) data_ptr;
+	T_DP_DOWNLOAD_REQ *dl;
+	u_int32           pos, len;
+	u_int8            n;
+
+	OSS_MemFill( llHdl->osHdl, DP_MAX_NUMBER_SLAVES * sizeof(*idx), (char*) idx, 0x00 );
+
+	if( TWISTWORD(pcfg->version) != M57_PCFG_VERSION ||
+		TWISTWORD(pcfg->hdrLen) != sizeof(M57_PCFG_HDR) ||
+		TWISTLONG(pcfg->size) > data_size ||
+		pcfg->lowestSlAddr >= DP_MAX_NUMBER_SLAVES ||
+		pcfg->numDl == 0 ){
+		DBGWRT_ERR((DBH, " *** LL - dp_pcfg_check: bad header\n"));
+		return -1;
+	}
+	data_size = TWISTLONG(pcfg->size);
+
+	for( pos = sizeof(M57_PCFG_HDR), n = 0; n < pcfg->numDl; n++, pos += (len + 1) & ~1 ){
+		dl = (T_DP_DOWNLOAD_REQ*) (data_ptr + pos);
+		if( pos > data_size || data_size - pos < sizeof(*dl) ||
+			(len = sizeof(*dl) + TWISTWORD(dl->data_len)) > data_size - pos ||
+			len > DP_MAX_TELEGRAM_LEN ||
+			(n == 0) != (dl->area_code == DP_AREA_BUS_PARAM) ||
+			(n && (dl->area_code >= DP_MAX_NUMBER_SLAVES ||
+				   idx[dl->area_code].offs)) ){
+			DBGWRT_ERR((DBH, " *** LL - dp_pcfg_check: bad download block %d "
+						"at %04x\n", n, pos));
+			OSS_MemFill( llHdl->osHdl, DP_MAX_NUMBER_SLAVES * sizeof(*idx), (char*) idx, 0x00 );
+			return -1;
+		}
+		if( n ){
+			CFG_SLAVE *cs = &idx[dl->area_code];
+
+			cs->offs    = pos;
+			cs->len     = TWISTWORD(dl->data_len);
+			cs->dlLen   = TWISTWORD(dl->data_len);
+			cs->num_in  = pcfg->chInfo[dl->area_code][0];
+			cs->num_out = pcfg->chInfo[dl->area_code][1];
+		}
+	}
+	return 0;
+}
+
+/****************************** dp_diag_alloc *******************************
+ *
+ *  Description: Build slave diag store for the current configuration
+ *
+ *               The store holds one entry of MAX_SLAVE_DIAG_LEN bytes
+ *               (rounded up to 4) for each slave in llHdl->cfgIdx,
+ *               llHdl->diagSlot maps the slave address to its entry.
+ *               The store is kept over reconfigurations and only
+ *               reallocated when it is too small. All entries are set
+ *               to "station non existent".
+ *               Without memory, diag indications are not stored.
+ *
+ *---------------------------------------------------------------------------
+ *  Input......: llHdl		low-level handle
+ *  Output.....: -
+ *  Globals....: -
+ ****************************************************************************/
 
+static void dp_diag_alloc( LL_HANDLE* llHdl ) /* nodoc */
 {
-	u_int32 size;
-	size = TWISTWORD( *((u_int16*) data_ptr));
-	return size;
+	T_DP_DIAG_DATA *diag;
+	u_int32        i, num, len;
+	u_int8         slot;
+
+	len = llHdl->maxSlaveDiagLen;
+	if ( len < DP_MIN_SLAVE_DIAG_LEN )
+		len = DP_MIN_SLAVE_DIAG_LEN;
+	if ( len > DP_MAX_SLAVE_DIAG_DATA_LEN )
+		len = DP_MAX_SLAVE_DIAG_DATA_LEN;
+	len = (len + 3) & ~3;
+
+	for ( i = 0, num = 0; i < DP_MAX_NUMBER_SLAVES; i++ )
+		if ( llHdl->cfgIdx[i].offs )
+			num++;
+
+	/* ISR-Task stores entries with window pointer semaphore taken */
+	semTake( llHdl->windowPointerSemId, WAIT_FOREVER );
+
+	if ( llHdl->diagStore && len * num > llHdl->diagMemSize ) {
+		OSS_MemFree( llHdl->osHdl, llHdl->diagStore, llHdl->diagMemSize );
+		llHdl->diagStore = NULL;
+	}
+	if ( llHdl->diagStore == NULL && num ) {
+		llHdl->diagStore = (u_int8*) OSS_MemGet( llHdl->osHdl, len * num,
+												 &llHdl->diagMemSize );
+		if ( llHdl->diagStore == NULL ) {
+			DBGWRT_ERR((DBH, " *** LL - dp_diag_alloc: can't alloc diag store\n"));
+		}
+	}
+	llHdl->diagEntrySize = (u_int16) len;
+	OSS_MemFill( llHdl->osHdl, sizeof(llHdl->diagBits), (char*) llHdl->diagBits, 0x00 );
+	OSS_MemFill( llHdl->osHdl, sizeof(llHdl->diagGen), (char*) llHdl->diagGen, 0x00 );
+
+	for ( i = 0, slot = 0; i < (DP_MAX_NUMBER_SLAVES + 1); i++ ) {
+		llHdl->diagSlot[i] = DP_DIAG_NO_SLOT;
+		if ( i == DP_MAX_NUMBER_SLAVES || llHdl->cfgIdx[i].offs == 0 ||
+			 llHdl->diagStore == NULL )
+			continue;
+
+		llHdl->diagSlot[i] = slot;
+		diag = (T_DP_DIAG_DATA*) DP_DIAG_ENTRY(llHdl, slot);
+		OSS_MemFill( llHdl->osHdl, len, (char*) diag, 0x00 );
+		diag->station_status_1 = DP_DIAG_1_STATION_NON_EXISTENT;
+		diag->master_add = 0xff;
+		slot++;
+	}
+
+	semGive( llHdl->windowPointerSemId );
+
+	DBGWRT_2((DBH, "LL - dp_diag_alloc: %d entries of %d bytes\n", num, len));
 }
 
+/***************************** dp_diag_refetch ******************************
+ *
+ *  Description: Read diag of all configured slaves into the diag store
+ *
+ *               Used after re-attach to a running firmware, the diag
+ *               indications received before went to the previous driver
+ *               instance or were dropped by cmi_attach. Each slave is
+ *               asked with DP_SLAVE_DIAG, slaves without answer keep
+ *               "station non existent". Stops at the first failed request.
+ *
+ *---------------------------------------------------------------------------
+ *  Input......: llHdl		low-level handle
+ *  Output.....: -
+ *  Globals....: -
+ ****************************************************************************/
+
+static void dp_diag_refetch( LL_HANDLE* llHdl ) /* nodoc */
+{
+	T_DP_SLAVE_DIAG_REQ  req;
+	T_DP_SLAVE_DIAG_CON *con;
+	u_int8   conBuf[DP_MAX_TELEGRAM_LEN];
+	u_int16  status;
+	u_int32  i;
+
+	if ( llHdl->stackState == DP_ST_OFFLINE )
+		return;
+
+	con = (T_DP_SLAVE_DIAG_CON*) conBuf;
+	for ( i = 0; i < DP_MAX_NUMBER_SLAVES; i++ ) {
+		if ( llHdl->diagSlot[i] == DP_DIAG_NO_SLOT )
+			continue;
+
+		req.rem_add = (u_int8) i;
+		req.dummy   = 0;
+		if ( req_con( llHdl, DP, DP_SLAVE_DIAG, (u_int8*) &req, &status,
+					  conBuf ) < 0 ) {
+			DBGWRT_ERR((DBH, " *** LL - dp_diag_refetch: slave %d no CON\n", i));
+			break;
+		}
+		if ( status || con->status )
+			continue;
+
+		semTake( llHdl->windowPointerSemId, WAIT_FOREVER );
+		dp_diag_update( llHdl, (u_int8) i, (u_int8*) (con + 1),
+						TWISTWORD(con->diag_data_len) );
+		semGive( llHdl->windowPointerSemId );
+	}
+}
+
+/***************************** dp_diag_update *******************************
+ *
+ *  Description: Store slave diag entry received by the ISR-Task
+ *
+ *               Only configured slaves are stored, the data is truncated
+ *               to the entry size and the rest of the entry is cleared.
+ *               If station_status_1..3 or the ext. diag bytes differ
+ *               from the stored entry, the diag generation of the slave
+ *               is incremented and its bit in llHdl->diagBits is set.
+ *               The window pointer semaphore must be taken.
+ *
+ *---------------------------------------------------------------------------
+ *  Input......: llHdl		low-level handle
+ *               addr       slave address
+ *               data       diag data (T_DP_DIAG_DATA + ext. diag)
+ *               len        length of diag data
+ *  Output.....: -
+ *  Globals....: -
+ ****************************************************************************/
+
+static void dp_diag_update( LL_HANDLE* llHdl, u_int8 addr, u_int8* data, u_int32 len ) /* nodoc */
+{
+	u_int8  *entry, b;
+	u_int32 i, changed = 0;
+
+	if ( addr >= DP_MAX_NUMBER_SLAVES || llHdl->diagSlot[addr] == DP_DIAG_NO_SLOT )
+		return;
+
+	entry = DP_DIAG_ENTRY(llHdl, llHdl->diagSlot[addr]);
+	for ( i = 0; i < llHdl->diagEntrySize; i++ ) {
+		b = i < len ? data[i] : 0x00;
+		if ( entry[i] == b )
+			continue;
+
+		/* master_add and ident_number are no new diag */
+		if ( i < 3 || i >= sizeof(T_DP_DIAG_DATA) )
+			changed = 1;
+		entry[i] = b;
+	}
+
+	if ( changed ) {
+		llHdl->diagGen[addr]++;
+		llHdl->diagBits[addr / 32] |= 1UL << (addr % 32);
+		IDBGWRT_2((DBH, " >>> dp_diag_update: new diag addr=0x%02x gen=%d\n",
+				   addr, llHdl->diagGen[addr]));
+		dp_diag_hist_add( llHdl, addr, data, len );
+	}
+}
+
+/**************************** dp_diag_hist_add ******************************
+ *
+ *  Description: Append record to slave diag history
+ *
+ *               When the history is full, the oldest record is
+ *               overwritten. The window pointer semaphore must be taken.
+ *
+ *---------------------------------------------------------------------------
+ *  Input......: llHdl		low-level handle
+ *               addr       slave address
+ *               data       diag data (T_DP_DIAG_DATA + ext. diag)
+ *               len        length of diag data
+ *  Output.....: -
+ *  Globals....: -
+ ****************************************************************************/
+
+static void dp_diag_hist_add( LL_HANDLE* llHdl, u_int8 addr, u_int8* data, u_int32 len ) /* nodoc */
+{
+	PROFIDP_DIAG_REC *rec;
+	u_int32 slot;
+
+	if ( llHdl->diagHist == NULL )
+		return;
+
+	if ( llHdl->diagHistCnt == llHdl->diagHistNum ) {
+		/* drop oldest */
+		if ( ++llHdl->diagHistRd == llHdl->diagHistNum )
+			llHdl->diagHistRd = 0;
+		llHdl->diagHistCnt--;
+	}
+
+	/* slot indices stay below diagHistNum, the sequence number wraps freely */
+	slot = llHdl->diagHistRd + llHdl->diagHistCnt;
+	if ( slot >= llHdl->diagHistNum )
+		slot -= llHdl->diagHistNum;
+
+	rec = (PROFIDP_DIAG_REC*) llHdl->diagHist + slot;
+	rec->time = dp_time64_us( llHdl );
+	rec->seq  = llHdl->diagHistSeq;
+	rec->addr = addr;
+	rec->_pad = 0;
+	rec->len  = (u_int16) len;
+	if ( len > PROFIDP_DIAG_HIST_DATA )
+		len = PROFIDP_DIAG_HIST_DATA;
+	OSS_MemFill( llHdl->osHdl, PROFIDP_DIAG_HIST_DATA, (char*) rec->data, 0x00 );
+	OSS_MemCopy( llHdl->osHdl, len, (char*) data, (char*) rec->data );
+
+	llHdl->diagHistSeq++;
+	llHdl->diagHistCnt++;
+}
+
+
+/******************************** fw_open **********************************
+ *
+ *  Description: Start reading the data of a firmware segment
+ *
+ *---------------------------------------------------------------------------
+ *  Input......: fs         stream
+ *               seg_off    offset in firmware array
+ *               llHdl      low-level handle
+ *
+ *  Output.....: -
+ *  Globals....: -
+ ****************************************************************************/
+
+static void fw_open ( FW_STREAM *fs, u_int32 seg_offs, LL_HANDLE* llHdl ) /* nodoc */
+{
+	fs->src    = &dp_fw[(seg_offs + M57_ARRAY_OFFS)];
+	fs->packed = llHdl->fwPacked;
+	fs->left   = 0;
+	fs->pos    = 0;
+}
+
+/******************************** fw_read **********************************
+ *
+ *  Description: Read the next words of a firmware segment
+ *
+ *               Packed segments are unpacked on the fly, only the last
+ *               M57_PACK_WINDOW words are kept for copy tokens.
+ *
+ *---------------------------------------------------------------------------
+ *  Input......: fs         stream
+ *               buf        buffer for words (as written to module RAM)
+ *               num        nbr of words to read
+ *
+ *  Output.....: return     nbr of words read (num)
+ *  Globals....: -
+ ****************************************************************************/
+
+static u_int32 fw_read ( FW_STREAM *fs, u_int16 *buf, u_int32 num ) /* nodoc */
+{
+	const u_int8 *src = fs->src;
+	u_int16 w;
+	u_int32 n;
+
+	if( !fs->packed ){
+		const u_int16 *p = (const u_int16*) src;
+
+		for( n = 0; n < num; n++ )
+			buf[n] = TWISTWORD(p[n]);
+		fs->src = src + 2 * num;
+		return num;
+	}
+
+	for( n = 0; n < num; n++ ){
+		/* next token */
+		if( fs->left == 0 ){
+			fs->tok = *src++;
+			if( fs->tok < M57_PACK_RUN )
+				fs->left = (u_int8) (fs->tok + 1);
+			else {
+				fs->left = (u_int8) ((fs->tok & 0x3f) + 2);
+				if( fs->tok < M57_PACK_COPY ){
+					((u_int8*) &fs->word)[0] = *src++;
+					((u_int8*) &fs->word)[1] = *src++;
+				}
+				else
+					fs->dist = (u_int16) (*src++ + 1);
+			}
+		}
+
+		/* words are kept in the byte order of the file */
+		if( fs->tok < M57_PACK_RUN ){
+			((u_int8*) &w)[0] = *src++;
+			((u_int8*) &w)[1] = *src++;
+		}
+		else if( fs->tok < M57_PACK_COPY )
+			w = fs->word;
+		else
+			w = fs->hist[(fs->pos - fs->dist) & (M57_PACK_WINDOW - 1)];
+
+		fs->hist[fs->pos & (M57_PACK_WINDOW - 1)] = w;
+		fs->pos++;
+		fs->left--;
+		buf[n] = TWISTWORD(w);
+	}
+
+	fs->src = src;
+	return num;
+}
 
 /****************************** load_segment *******************************
  *
  *  Description: Load a firmware segment
  *
+ *               In DPRAM_DIRECT mode the segment is written through the
+ *               A24 address space instead of the A08 window. The segment
+ *               is read in chunks of FW_CHUNK words, the inner loops are
+ *               unrolled to four words per pass.
+ *
  *---------------------------------------------------------------------------
  *  Input......: base       base address of memory window
  *               seg_off    offset in firmware array
@@ -2628,16 +4796,48 @@ static u_int32 _skip_align(LL_HANDLE* llHdl, u_int8* data_ptr ) /* nodoc */
 static void load_segment ( MACCESS base, u_int32 seg_offs,
                     u_int32 offset, u_int32 length, LL_HANDLE* llHdl ) /* nodoc */
 {
-	u_int16 *p = (u_int16*) &dp_fw[(seg_offs + M57_ARRAY_OFFS)];
+	FW_STREAM fs;
+	u_int16 buf[FW_CHUNK];
+	u_int32 n, i;
 
-	DBGWRT_2((DBH,"\nseg_offs = %08x, base = %08p, offset = %08x, length = %08x, *p = %04x\n",
-	        seg_offs, (void*)base, offset, length, *p));
-	SET_WINDOW( base, offset );
+	DBGWRT_2((DBH,"\nseg_offs = %08x, base = %08p, offset = %08x, length = %08x\n",
+	        seg_offs, (void*)base, offset, length));
+
+	fw_open( &fs, seg_offs, llHdl );
+
+	/* data port increments the window pointer */
+	if( !llHdl->dpramDirect )
+		SET_WINDOW_PORT( base, offset );
 
 	while( length > 0 ){
-		DP_DATA_W_WRITE( base, TWISTWORD(*p) );
-		p++;
-		length -= 2;
+		n = fw_read( &fs, buf, (length / 2) < FW_CHUNK ? (length / 2) : FW_CHUNK );
+
+		if( llHdl->dpramDirect ){
+			/* direct access, no window pointer */
+			for( i = 0; i + 4 <= n; i += 4 ){
+				DP_A24_W_WRITE( llHdl->maDpram, offset,     buf[i] );
+				DP_A24_W_WRITE( llHdl->maDpram, offset + 2, buf[i+1] );
+				DP_A24_W_WRITE( llHdl->maDpram, offset + 4, buf[i+2] );
+				DP_A24_W_WRITE( llHdl->maDpram, offset + 6, buf[i+3] );
+				offset += 8;
+			}
+			for( ; i < n; i++ ){
+				DP_A24_W_WRITE( llHdl->maDpram, offset, buf[i] );
+				offset += 2;
+			}
+		}
+		else {
+			for( i = 0; i + 4 <= n; i += 4 ){
+				DP_DATA_W_WRITE( base, buf[i] );
+				DP_DATA_W_WRITE( base, buf[i+1] );
+				DP_DATA_W_WRITE( base, buf[i+2] );
+				DP_DATA_W_WRITE( base, buf[i+3] );
+			}
+			for( ; i < n; i++ )
+				DP_DATA_W_WRITE( base, buf[i] );
+		}
+
+		length -= 2 * n;
 	}
 }
 
@@ -2646,6 +4846,9 @@ static void load_segment ( MACCESS base, u_int32 seg_offs,
  *
  *  Description: Verify a firmware segment
  *
+ *               With FW_VERIFY = 1 only every DP_FW_VERIFY_STEP word and
+ *               the last word of the segment are compared.
+ *
  *---------------------------------------------------------------------------
  *  Input......: base       base address of memory window
  *               seg_off    offset in firmware array
@@ -2660,28 +4863,213 @@ static void load_segment ( MACCESS base, u_int32 seg_offs,
 static int verify_fw_segment ( MACCESS base, u_int32 seg_offs,
                          u_int32 offset, u_int32 length, LL_HANDLE* llHdl) /* nodoc */
 {
+	FW_STREAM fs;
+	u_int16 buf[FW_CHUNK];
 	u_int16 rval;
-	u_int16 *p = (u_int16 *) &dp_fw[(seg_offs + M57_ARRAY_OFFS)];
+	u_int32 words = length / 2;
+	u_int32 step  = 1;
+	u_int32 w = 0, n, i;
 
-	SET_WINDOW( base, offset );
+	if( llHdl->fwVerify == DP_FW_VERIFY_SAMPLED )
+		step = DP_FW_VERIFY_STEP;
 
-	while( length > 0 ){
+	fw_open( &fs, seg_offs, llHdl );
+
+	if( !llHdl->dpramDirect )
+		SET_WINDOW_PORT( base, offset );
 
-		rval = DP_DATA_W_READ( base );
+	while( w < words ){
+		n = fw_read( &fs, buf, (words - w) < FW_CHUNK ? (words - w) : FW_CHUNK );
 
-		if( rval != TWISTWORD(*p)){
-			DBGWRT_ERR((DBH,"*** PROFIDP_Init: Error verifying firmware!\n"));
-			DBGWRT_ERR((DBH,"*** PROFIDP_Init: Error at address offset"
-			                " $%x should be $%04x, is $%04x\n",
-			                offset, *p, rval ));
-			return (-1);
+		for( i = 0; i < n; i++, w++ ){
+			/* sampled: compare last word of segment too */
+			if( step > 1 && (w % step) != step - 1 && w != words - 1 )
+				continue;
+
+			if( llHdl->dpramDirect )
+				rval = DP_A24_W_READ( llHdl->maDpram, offset + 2 * w );
+			else {
+				if( step > 1 )
+					SET_WINDOW_PORT( base, (offset + 2 * w) );
+				rval = DP_DATA_W_READ( base );
+			}
+
+			if( rval != buf[i] ){
+				DBGWRT_ERR((DBH,"*** PROFIDP_Init: Error verifying firmware!\n"));
+				DBGWRT_ERR((DBH,"*** PROFIDP_Init: Error at address offset"
+				                " $%x should be $%04x, is $%04x\n",
+				                offset + 2 * w, buf[i], rval ));
+				return (-1);
+			}
 		}
-		p++;
+	}
+return (0);
+
+}
+
+/***************************** crc_fw_segment *******************************
+ *
+ *  Description: Update CRC32 with a firmware segment
+ *
+ *               Either the words of the firmware image or the words read
+ *               back from module RAM are used, so both CRCs are equal if
+ *               the module RAM holds the image.
+ *
+ *---------------------------------------------------------------------------
+ *  Input......: base       base address of memory window
+ *               seg_off    offset in firmware array
+ *               offset     load address in DRAM
+ *               length     data length of segment
+ *               llHdl      low-level handle
+ *               crc        CRC so far (start with 0xffffffff)
+ *               readback   0=firmware image, 1=module RAM
+ *
+ *  Output.....: return     updated CRC
+ *  Globals....: -
+ ****************************************************************************/
+
+static u_int32 crc_fw_segment ( MACCESS base, u_int32 seg_offs, u_int32 offset,
+                         u_int32 length, LL_HANDLE* llHdl, u_int32 crc, int readback ) /* nodoc */
+{
+	FW_STREAM fs;
+	u_int16 buf[FW_CHUNK];
+	u_int16 val;
+	u_int32 n = 0, i = 0;
+
+	if( readback ){
+		if( !llHdl->dpramDirect )
+			SET_WINDOW_PORT( base, offset );
+	}
+	else
+		fw_open( &fs, seg_offs, llHdl );
+
+	while( length > 0 ){
+		if( !readback ){
+			if( i == n ){
+				n = fw_read( &fs, buf, (length / 2) < FW_CHUNK ? (length / 2) : FW_CHUNK );
+				i = 0;
+			}
+			val = buf[i++];
+		}
+		else if( llHdl->dpramDirect )
+			val = DP_A24_W_READ( llHdl->maDpram, offset );
+		else
+			val = DP_DATA_W_READ( base );
+
+		/* 4 bit table, high byte first */
+		crc ^= (u_int32) (val >> 8);
+		crc = (crc >> 4) ^ dp_crcTab[crc & 0xf];
+		crc = (crc >> 4) ^ dp_crcTab[crc & 0xf];
+		crc ^= (u_int32) (val & 0xff);
+		crc = (crc >> 4) ^ dp_crcTab[crc & 0xf];
+		crc = (crc >> 4) ^ dp_crcTab[crc & 0xf];
+
 		offset += 2;
 		length -= 2;
 	}
-return (0);
 
+	return crc;
+}
+
+/********************************* dp_crc32 *********************************
+ *
+ *  Description: Update CRC32 (as crc_fw_segment) with a byte array
+ *
+ *---------------------------------------------------------------------------
+ *  Input......: crc        CRC so far (start with 0xffffffff)
+ *               p          data
+ *               len        nbr of bytes
+ *  Output.....: return     updated CRC
+ *  Globals....: -
+ ****************************************************************************/
+static u_int32 dp_crc32 ( u_int32 crc, const u_int8 *p, u_int32 len ) /* nodoc */
+{
+	while( len-- ){
+		crc ^= *p++;
+		crc = (crc >> 4) ^ dp_crcTab[crc & 0xf];
+		crc = (crc >> 4) ^ dp_crcTab[crc & 0xf];
+	}
+	return crc;
+}
+
+/******************************* dp_desc_crc ********************************
+ *
+ *  Description: CRC32 of the descriptor values used by PROFIDP_Config
+ *
+ *               A running firmware is only re-attached if it was configured
+ *               with the same values.
+ *
+ *---------------------------------------------------------------------------
+ *  Input......: llHdl      low-level handle
+ *  Output.....: return     CRC
+ *  Globals....: -
+ ****************************************************************************/
+static u_int32 dp_desc_crc ( LL_HANDLE* llHdl ) /* nodoc */
+{
+	u_int32 val[10];
+
+	val[0] = llHdl->addrAssignMode;
+	val[1] = llHdl->maxNumSlaves;
+	val[2] = llHdl->maxSlaveDiagEntries;
+	val[3] = llHdl->maxSlaveDiagLen;
+	val[4] = llHdl->clearOutputs;
+	val[5] = llHdl->autoRemoteService;
+	val[6] = llHdl->cyclicDataTransfer;
+	val[7] = llHdl->masterClass2;
+	val[8] = llHdl->lowest_slave_address;
+	val[9] = llHdl->dpramDirect;
+
+	return dp_crc32( 0xffffffff, (u_int8*) val, sizeof(val) );
+}
+
+/******************************* dp_hot_find ********************************
+ *
+ *  Description: Find state of a module left running by PROFIDP_Exit
+ *
+ *---------------------------------------------------------------------------
+ *  Input......: ma         module, 0 for a free entry
+ *  Output.....: return     entry or NULL
+ *  Globals....: PROFIDP_hotState
+ ****************************************************************************/
+static DP_HOT_STATE* dp_hot_find ( MACCESS ma ) /* nodoc */
+{
+	int i;
+
+	for( i = 0; i < DP_HOT_MAX_MOD; i++ )
+		if( PROFIDP_hotState[i].ma == ma )
+			return &PROFIDP_hotState[i];
+	return NULL;
+}
+
+/****************************** dp_hot_attach *******************************
+ *
+ *  Description: Re-attach to a firmware left running by PROFIDP_Exit
+ *
+ *               The firmware must be identical to dp_fw and configured with
+ *               CONFIG_HASH and the same descriptor values. The CMI state
+ *               is read from the module, the module is not reset.
+ *
+ *---------------------------------------------------------------------------
+ *  Input......: llHdl      low-level handle (fwCrc, descCrc set)
+ *               hs         saved module state
+ *  Output.....: return     0 = re-attached, -1 = not possible
+ *  Globals....: -
+ ****************************************************************************/
+static int32 dp_hot_attach ( LL_HANDLE* llHdl, DP_HOT_STATE* hs ) /* nodoc */
+{
+	if( hs->fwCrc != llHdl->fwCrc || hs->descCrc != llHdl->descCrc ||
+		llHdl->cfgHashDesc == 0 || hs->cfgHash != llHdl->cfgHashDesc ){
+		DBGWRT_2((DBH,"LL - dp_hot_attach: running firmware/config differs "
+				  "(cfg hash %08x, expected %08x)\n", hs->cfgHash, llHdl->cfgHashDesc ));
+		return -1;
+	}
+
+	if( profi_attach( llHdl ) != E_OK )
+		return -1;
+
+	llHdl->cfgHash    = hs->cfgHash;
+	llHdl->stackState = hs->stackState;
+	return 0;
 }
 
 /******************************* req_con ************************************
@@ -2696,6 +5084,11 @@ return (0);
  *				  data_ptr:   service specific data
  *				  status_ptr: pointer to u_int16 to store the status code
  *							  returned with the confirmation
+ *				  con_ptr:    buffer for CON data or NULL
+ *
+ *                Each request has its own pending request slot. The
+ *                caller keeps the device semaphore while it waits for
+ *                the CON, use PROFIDP_BLK_SUBMIT_REQ to overlap requests.
  *
  *  Output.....:  0: ok
  *				  1: Unsuccessful status in CON, see *status_ptr
@@ -2704,48 +5097,193 @@ return (0);
  ****************************************************************************/
 
 static int16 req_con( LL_HANDLE* llHdl, u_int8 layer, u_int8 service,
-                    u_int8* data_ptr, u_int16* status_ptr ) /* nodoc */
+                    u_int8* data_ptr, u_int16* status_ptr, u_int8* con_ptr ) /* nodoc */
 {
 	T_PROFI_SERVICE_DESCR psd;
+	PEND_REQ *req;
 	u_int16 error;
 
+	/* register request, so several requests can wait for their CON */
+	if( (req = PROFIDP_pendReqAlloc( llHdl, (layer == DP) ? DP_USR : FMB_USR,
+									 service, 0 )) == NULL ) {
+		DBGWRT_ERR((DBH," *** PROFIDP_req_con: no free pending request slot\n"));
+		return -1;
+	}
+
 	psd.comm_ref = TWISTWORD(0);
 	psd.layer = layer;
 	psd.service = service;
 	psd.primitive = REQ;
+	psd.invoke_id = req->invoke_id;
 
 	/*---------------------------------+
     |  Send Request to protocol stack  |
     +---------------------------------*/
 	DBGWRT_2((DBH, "LL - PROFIDP_req_con\n"));
 
-	if( (error = profi_snd_req_res_usr( llHdl, &psd, data_ptr, 1 ))){
+	if( (error = profi_snd_req_res_usr( llHdl, &psd, data_ptr ))){
 		DBGWRT_ERR((DBH," *** profi_snd_req_res_usr: ERROR error code = %04xh\n", error ));
+		PROFIDP_pendReqFree( llHdl, req );
 		return -1;
 	}
 
 	/* wait for confiramtion */
-	if ((OSS_SemWait( llHdl->osHdl, llHdl->req_con_0f_semP, 5000 )) != 0) {
+	if ((OSS_SemWait( llHdl->osHdl, req->semP, 5000 )) != 0) {
 		DBGWRT_ERR((DBH," *** PROFIDP_req_con: Error or Timeout REQ/CON semaphore\n"));
+		PROFIDP_pendReqFree( llHdl, req );
 		return ( -1 );
 	}
 
-	if( llHdl->waitForService.result == NEG ){
-		*status_ptr = (u_int16)((llHdl->req_con_buf[0] << 8) + llHdl->req_con_buf[1]);
+	if( con_ptr )
+		OSS_MemCopy(llHdl->osHdl, sizeof (req->conBuf), (char*) req->conBuf, (char*) con_ptr);
+
+	if( req->result == NEG ){
+		*status_ptr = (u_int16)((req->conBuf[0] << 8) + req->conBuf[1]);
 
 		if( *status_ptr ){
 				DBGWRT_ERR((DBH," *** Bad status in confirmation: %04x\n", *status_ptr ));
 			}
-		/* clear wait for service structure */
-		waitForService_clear ( llHdl );
+		PROFIDP_pendReqFree( llHdl, req );
 		return *status_ptr ? 1 : 0;
 	}
-	/* clear wait for service structure */
-	waitForService_clear ( llHdl );
+	PROFIDP_pendReqFree( llHdl, req );
 	return (0); /* POS */
 
 }
 
+/************************** PROFIDP_pendReqAlloc ****************************
+ *
+ *  Description:  Allocate pending request slot
+ *
+ *                Waits max 5s for a free slot. The slot's invoke id must
+ *                be used for the REQ.
+ *
+ *---------------------------------------------------------------------------
+ *  Input......:  llHdl     low-level handle
+ *                layer     layer of expected CON
+ *                service   service of expected CON
+ *                comm_ref  comm ref of REQ
+ *  Output.....:  return    slot or NULL
+ *  Globals....:  -
+ ****************************************************************************/
+static PEND_REQ* PROFIDP_pendReqAlloc( LL_HANDLE* llHdl, u_int8 layer, u_int8 service,
+									   u_int16 comm_ref ) /* nodoc */
+{
+	PEND_REQ *req = NULL;
+	int n;
+
+	if ((OSS_SemWait( llHdl->osHdl, llHdl->pendReqFreeSemP, 5000 )) != 0)
+		return NULL;
+
+	/* the ISR-Task completes slots while holding the window pointer semaphore */
+	semTake( llHdl->windowPointerSemId, WAIT_FOREVER );
+	for( n = 0; n < DP_MAX_PEND_REQ; n++ ){
+		if( !llHdl->pendReq[n].used ) {
+			req = &llHdl->pendReq[n];
+			req->used     = 1;
+			req->done     = 0;
+			req->layer    = layer;
+			req->service  = service;
+			req->comm_ref = comm_ref;
+			req->seq      = llHdl->pendReqSeq++;
+			req->async    = 0;
+			req->sent     = 1;	/* sent by caller right now */
+			/* remove signal of a CON received after timeout */
+			OSS_SemWait( llHdl->osHdl, req->semP, OSS_SEM_NOWAIT );
+			break;
+		}
+	}
+	semGive( llHdl->windowPointerSemId );
+
+	return req;
+}
+
+/************************** PROFIDP_pendReqFree *****************************
+ *
+ *  Description:  Release pending request slot
+ *
+ *---------------------------------------------------------------------------
+ *  Input......:  llHdl     low-level handle
+ *                req       slot
+ *  Output.....:  -
+ *  Globals....:  -
+ ****************************************************************************/
+static void PROFIDP_pendReqFree( LL_HANDLE* llHdl, PEND_REQ* req ) /* nodoc */
+{
+	semTake( llHdl->windowPointerSemId, WAIT_FOREVER );
+	req->used = 0;
+	semGive( llHdl->windowPointerSemId );
+
+	OSS_SemSignal( llHdl->osHdl, llHdl->pendReqFreeSemP );
+}
+
+/************************ PROFIDP_pendReqComplete ***************************
+ *
+ *  Description:  Complete pending request with received CON
+ *
+ *                The CON is matched by layer, service, invoke id and
+ *                comm ref. If no slot matches exactly, the oldest slot
+ *                waiting for the same layer and service gets it.
+ *                Called by the ISR-Task.
+ *
+ *---------------------------------------------------------------------------
+ *  Input......:  llHdl     low-level handle
+ *                c_sdb     service descr block of CON/IND
+ *                data      CON/IND data
+ *                len       length of CON/IND data
+ *  Output.....:  return    1 = CON completed a pending request
+ *  Globals....:  -
+ ****************************************************************************/
+static int PROFIDP_pendReqComplete( LL_HANDLE* llHdl, T_PROFI_SERVICE_DESCR* c_sdb,
+									u_int8* data, u_int16 len ) /* nodoc */
+{
+	PEND_REQ *req = NULL;
+	PEND_REQ *p;
+	int n;
+
+	if( c_sdb->primitive != CON )
+		return 0;
+
+	for( n = 0; n < DP_MAX_PEND_REQ; n++ ){
+		p = &llHdl->pendReq[n];
+		if( !p->used || p->done || !p->sent || p->layer != c_sdb->layer ||
+			p->service != c_sdb->service )
+			continue;
+
+		if( p->invoke_id == c_sdb->invoke_id && p->comm_ref == c_sdb->comm_ref ) {
+			req = p;
+			break;
+		}
+		/* diag CON of ISR-Task's request must not be taken by fallback */
+		if( c_sdb->service == DP_GET_SLAVE_DIAG && llHdl->getSlaveDiagReqWaitCon )
+			continue;
+		if( req == NULL || (int32) (p->seq - req->seq) < 0 )
+			req = p;
+	}
+
+	if( req == NULL )
+		return 0;
+
+	if( len > sizeof (req->conBuf) )
+		len = sizeof (req->conBuf);
+	OSS_MemCopy(llHdl->osHdl, len, (char*) data, (char*) req->conBuf);
+	req->conLen = len;
+	req->result = c_sdb->result;
+
+	if( req->async ) {
+		req->sdb = *c_sdb;
+		PROFIDP_asyncDone( llHdl, req, ERR_SUCCESS );
+		return 1;
+	}
+
+	req->done   = 1;
+	if ((OSS_SemSignal( llHdl->osHdl, req->semP )) != 0) {
+		DBGWRT_ERR((DBH," *** PROFIDP_pendReqComplete: Error signaling REQ/CON semaphore\n"));
+	}
+
+	return 1;
+}
+
 /****************************** dp_setstate **********************************
  *
  *  Description:  Set state of protocol stack (OFFLINE, STOP, CLEAR, OPERATE)
@@ -2765,20 +5303,364 @@ static int16 req_con( LL_HANDLE* llHdl, u_int8 layer, u_int8 service,
  *				 -1 = fatal error, errno set.
  *  Globals....:
  ****************************************************************************/
-static int16 dp_setstate( LL_HANDLE* llHdl, u_int8 state, u_int16* con_status ) /* nodoc */
+static int16 dp_setstate( LL_HANDLE* llHdl, u_int8 state, u_int16* con_status ) /* nodoc */
+{
+	T_DP_ACT_PARAM_REQ ap;
+	int16 error;
+
+	ap.rem_add = llHdl->master_default_address; /* 1 */
+	ap.area_code = DP_AREA_SET_MODE;
+	ap.activate = state;
+
+    DBGWRT_2((DBH, "LL - PROFIDP_SetStat: Set state to %02x\n", state ));
+
+	error=req_con( llHdl, DP, DP_ACT_PARAM_LOC, (u_int8 *)&ap,
+					 con_status, NULL );
+	if( error == 0 )
+		llHdl->stackState = state;
+	return error;
+}
+
+/****************************** dp_act_slave *********************************
+ *
+ *  Description:  Activate or deactivate one slave
+ *
+ *                The other slaves continue data exchange.
+ *
+ *---------------------------------------------------------------------------
+ *  Input......:  llHdl:	low-level handle
+ *				  slave:	slave address
+ *				  activate:	DP_SLAVE_ACTIVATE or DP_SLAVE_DEACTIVATE
+ *				  con_status:
+ *							Status returned with unsuccessful confirmation
+ *							only valid when return value == 1
+ *  Output.....:  0 = everything ok
+ *				  1 = unsuccessful confirmation received.
+ *					  Status code in con_status
+ *				 -1 = fatal error
+ *  Globals....:
+ ****************************************************************************/
+static int16 dp_act_slave( LL_HANDLE* llHdl, u_int8 slave, u_int8 activate,
+						   u_int16* con_status ) /* nodoc */
+{
+	T_DP_ACT_PARAM_REQ ap;
+
+	ap.rem_add = llHdl->master_default_address;
+	ap.area_code = slave;
+	ap.activate = activate;
+	ap.dummy = 0;
+
+    DBGWRT_2((DBH, "LL - dp_act_slave: slave %d activate %02x\n", slave, activate ));
+
+	return req_con( llHdl, DP, DP_ACT_PARAM_LOC, (u_int8 *)&ap,
+					con_status, NULL );
+}
+
+/*************************** PROFIDP_slaveParam *****************************
+ *
+ *  Description:  Download parameter set of one slave
+ *
+ *                The slave is reparameterized while the other slaves
+ *                continue data exchange. Its in/outputs must fit into
+ *                the DPRAM layout of the current configuration, i.e.
+ *                max_slave_input_len, max_slave_output_len and the
+ *                max slave parameter length can't grow.
+ *                Only slaves of the current configuration can be
+ *                reparameterized, the diag store has no entry for others.
+ *                On success, the channel info of the slave is updated.
+ *
+ *---------------------------------------------------------------------------
+ *  Input......:  llHdl   low-level handle
+ *				  blk     slave address followed by T_DP_SLAVE_PARA_SET,
+ *                        as in the binary configuration
+ *
+ *  Output.....:  return  success (0) or error code
+ *  Globals....:  -
+ ****************************************************************************/
+static int32 PROFIDP_slaveParam( LL_HANDLE* llHdl, M_SG_BLOCK* blk ) /* nodoc */
+{
+	u_int8            *data = (u_int8*) blk->data;
+	T_DP_DOWNLOAD_REQ *dl;
+	CFG_SLAVE         cs;
+	u_int16           con_status;
+	u_int8            slave;
+
+	if ( blk->size < 1 + DP_CFG_SL_HDR_LEN ) {
+		DBGWRT_ERR((DBH, " *** PROFIDP_slaveParam: block too small\n"));
+		return (ERR_LL_USERBUF);
+	}
+	slave = data[0];
+
+	/*--- check parameter set and DPRAM layout ---*/
+	if ( llHdl->max_slave_para_len == 0 ||
+		 slave >= DP_MAX_NUMBER_SLAVES ||
+		 slave < llHdl->lowest_slave_address ||
+		 slave >= llHdl->lowest_slave_address + llHdl->maxNumSlaves ||
+		 llHdl->cfgIdx[slave].offs == 0 ) {
+		DBGWRT_ERR((DBH, " *** PROFIDP_slaveParam: slave %d not possible\n", slave));
+		return (ERR_LL_ILL_PARAM);
+	}
+	if ( dp_bincfg_slave( llHdl, data + 1, (u_int32) blk->size - 1, slave, &cs ) < 0 )
+		return (ERR_LL_ILL_PARAM);
+
+	if ( cs.num_in > llHdl->max_slave_input_len ||
+		 cs.num_out > llHdl->max_slave_output_len ||
+		 cs.dlLen > llHdl->max_slave_para_len ) {
+		DBGWRT_ERR((DBH, " *** PROFIDP_slaveParam: slave %d: in %d out %d len %d "
+					"exceed configuration\n", slave, cs.num_in, cs.num_out, cs.dlLen));
+		return (ERR_LL_ILL_PARAM);
+	}
+
+	/*--- download ---*/
+	dl = (T_DP_DOWNLOAD_REQ *) llHdl->req_con_buf;
+	dl->rem_add  = llHdl->master_default_address;
+	dl->area_code = slave;
+	dl->add_offset = TWISTWORD(0);
+	dl->data_len = TWISTWORD((u_int16) PROFIDP_copy_buspar( cs.len, data + 1, (u_int8*)(dl+1) ));
+
+	DBGWRT_2((DBH, "LL - PROFIDP_slaveParam: Loading slave parameter set %d\n", slave));
+	if ( req_con( llHdl, DP, DP_DOWNLOAD_LOC, (u_int8 *)dl, &con_status, NULL ) ) {
+		DBGWRT_ERR((DBH, " *** PROFIDP_slaveParam: download failed\n"));
+		return (PROFIDP_ERR_SLAVE_PARAM);
+	}
+
+	llHdl->cfgIdx[slave].len     = cs.len;
+	llHdl->cfgIdx[slave].dlLen   = cs.dlLen;
+	llHdl->cfgIdx[slave].num_in  = cs.num_in;
+	llHdl->cfgIdx[slave].num_out = cs.num_out;
+	llHdl->chInfo[slave].num_in  = cs.num_in;
+	llHdl->chInfo[slave].num_out = cs.num_out;
+	return (ERR_SUCCESS);
+}
+
+/************************** PROFIDP_asyncSubmit ****************************
+ *
+ *  Description:  Submit request without waiting for CON
+ *
+ *                The request is put into a free pending request slot and
+ *                queued for the submission task. Returns immediately with
+ *                PROFIDP_ERR_NO_REQ_SLOT if all slots are in use or
+ *                DP_MAX_ASYNC_REQ requests are submitted and not reaped,
+ *                the other slots are kept for the driver's own requests.
+ *                The CON is got later with PROFIDP_asyncReap().
+ *
+ *---------------------------------------------------------------------------
+ *  Input......:  llHdl   low-level handle
+ *				  blk     PROFIDP_ASYNC_REQ followed by T_PROFI_SERVICE_DESCR
+ *                        and service data
+ *
+ *  Output.....:  return  success (0) or error code
+ *  Globals....:  -
+ ****************************************************************************/
+static int32 PROFIDP_asyncSubmit( LL_HANDLE* llHdl, M_SG_BLOCK* blk ) /* nodoc */
+{
+	PROFIDP_ASYNC_REQ     *areq = (PROFIDP_ASYNC_REQ*) blk->data;
+	T_PROFI_SERVICE_DESCR *sdb  = (T_PROFI_SERVICE_DESCR*) (areq + 1);
+	PEND_REQ *req = NULL;
+	int n, num = 0;
+
+	if ( blk->size < (int32) (sizeof(PROFIDP_ASYNC_REQ) + sizeof(T_PROFI_SERVICE_DESCR)) ||
+		 areq->len > DP_MAX_TELEGRAM_LEN ||
+		 blk->size < (int32) (sizeof(PROFIDP_ASYNC_REQ) + sizeof(T_PROFI_SERVICE_DESCR) +
+							  areq->len) ) {
+		DBGWRT_ERR((DBH,"*** PROFIDP_asyncSubmit: block size to small\n"));
+		return (ERR_LL_USERBUF);
+	}
+
+	/* don't block if all slots are in use */
+	if ( OSS_SemWait( llHdl->osHdl, llHdl->pendReqFreeSemP, OSS_SEM_NOWAIT ) != 0 ) {
+		DBGWRT_ERR((DBH,"*** PROFIDP_asyncSubmit: no free request slot\n"));
+		return (PROFIDP_ERR_NO_REQ_SLOT);
+	}
+
+	semTake( llHdl->windowPointerSemId, WAIT_FOREVER );
+	for( n = 0; n < DP_MAX_PEND_REQ; n++ )
+		if( llHdl->pendReq[n].used && llHdl->pendReq[n].async )
+			num++;
+	if( num >= DP_MAX_ASYNC_REQ ) {
+		semGive( llHdl->windowPointerSemId );
+		OSS_SemSignal( llHdl->osHdl, llHdl->pendReqFreeSemP );
+		DBGWRT_ERR((DBH,"*** PROFIDP_asyncSubmit: max nbr of submitted requests\n"));
+		return (PROFIDP_ERR_NO_REQ_SLOT);
+	}
+
+	for( n = 0; n < DP_MAX_PEND_REQ; n++ ){
+		if( !llHdl->pendReq[n].used ) {
+			req = &llHdl->pendReq[n];
+			break;
+		}
+	}
+
+	req->used     = 1;
+	req->done     = 0;
+	req->async    = 1;
+	req->sent     = 0;
+	req->layer    = (sdb->layer == DP) ? DP_USR : FMB_USR;
+	req->service  = sdb->service;
+	req->comm_ref = sdb->comm_ref;
+	req->seq      = llHdl->pendReqSeq++;
+	req->tag      = areq->tag;
+	req->error    = ERR_SUCCESS;
+	req->sdb      = *sdb;
+	req->reqLen   = areq->len;
+	req->conLen   = 0;
+	OSS_MemCopy(llHdl->osHdl, areq->len, (char*) (sdb + 1), (char*) req->conBuf);
+
+	llHdl->sq[llHdl->sqIn++ % DP_MAX_PEND_REQ] = (u_int8) n;
+	semGive( llHdl->windowPointerSemId );
+
+	DBGWRT_2((DBH, "LL - PROFIDP_asyncSubmit: service=0x%02x tag=0x%x slot=%d\n",
+			  sdb->service, areq->tag, n));
+
+	OSS_SemSignal( llHdl->osHdl, llHdl->sqSemP );
+
+	return (ERR_SUCCESS);
+}
+
+/*************************** PROFIDP_asyncDone *****************************
+ *
+ *  Description:  Put submitted request into completion queue
+ *
+ *                Must be called with the window pointer semaphore held.
+ *
+ *---------------------------------------------------------------------------
+ *  Input......:  llHdl   low-level handle
+ *                req     slot
+ *                error   error code of completion
+ *  Output.....:  -
+ *  Globals....:  -
+ ****************************************************************************/
+static void PROFIDP_asyncDone( LL_HANDLE* llHdl, PEND_REQ* req, int32 error ) /* nodoc */
+{
+	req->error = error;
+	req->done  = 1;
+	llHdl->cq[llHdl->cqIn++ % DP_MAX_PEND_REQ] = (u_int8) (req - llHdl->pendReq);
+
+	OSS_SemSignal( llHdl->osHdl, llHdl->cqSemP );
+}
+
+/************************** PROFIDP_asyncExpire ****************************
+ *
+ *  Description:  Complete submitted requests without CON after
+ *                DP_ASYNC_TIMEOUT ms with PROFIDP_ERR_REQ_CON_TIMEOUT
+ *
+ *                Called by the submission task with the window pointer
+ *                semaphore held.
+ *
+ *---------------------------------------------------------------------------
+ *  Input......:  llHdl   low-level handle
+ *  Output.....:  -
+ *  Globals....:  -
+ ****************************************************************************/
+static void PROFIDP_asyncExpire( LL_HANDLE* llHdl ) /* nodoc */
+{
+	PEND_REQ *req;
+	int n;
+
+	for( n = 0; n < DP_MAX_PEND_REQ; n++ ){
+		req = &llHdl->pendReq[n];
+		if( req->used && req->async && req->sent && !req->done &&
+			(ACT_TICK - req->sentTick) >= (DP_ASYNC_TIMEOUT * TICK_RATE) / 1000 ) {
+			DBGWRT_ERR((DBH,"*** PROFIDP_asyncExpire: no CON for tag 0x%x\n", req->tag));
+			PROFIDP_asyncDone( llHdl, req, PROFIDP_ERR_REQ_CON_TIMEOUT );
+		}
+	}
+}
+
+/*************************** PROFIDP_asyncReap *****************************
+ *
+ *  Description:  Get as many completions of submitted requests as fit
+ *                into user buffer
+ *
+ *                Waits max reap->timeout ms until reap->minNum completions
+ *                are available. Requests without CON after
+ *                DP_ASYNC_TIMEOUT ms are completed with
+ *                PROFIDP_ERR_REQ_CON_TIMEOUT by the submission task.
+ *
+ *---------------------------------------------------------------------------
+ *  Input......:  llHdl   low-level handle
+ *				  blk     PROFIDP_ASYNC_REAP followed by space for completions
+ *
+ *  Output.....:  return  success (0) or error code
+ *  Globals....:  -
+ ****************************************************************************/
+static int32 PROFIDP_asyncReap( LL_HANDLE* llHdl, M_SG_BLOCK* blk ) /* nodoc */
 {
-	T_DP_ACT_PARAM_REQ ap;
-	int16 error;
+	PROFIDP_ASYNC_REAP *reap = (PROFIDP_ASYNC_REAP*) blk->data;
+	PROFIDP_ASYNC_CPL  *cpl;
+	PEND_REQ *req;
+	u_int8  *dst;
+	u_int32 rest, size, start, elapsed, avail;
+	u_int16 num = 0;
+
+	if ( blk->size < (int32) (sizeof(PROFIDP_ASYNC_REAP) +
+							  PROFIDP_ASYNC_CPL_SIZE( DP_MAX_TELEGRAM_LEN )) ) {
+		DBGWRT_ERR((DBH,"*** PROFIDP_asyncReap: block size to small\n"));
+		return (ERR_LL_USERBUF);
+	}
 
-	ap.rem_add = llHdl->master_default_address; /* 1 */
-	ap.area_code = DP_AREA_SET_MODE;
-	ap.activate = state;
+	/* wait for minNum completions */
+	start = ACT_TICK;
+	while ( 1 ) {
+		semTake( llHdl->windowPointerSemId, WAIT_FOREVER );
+		avail = llHdl->cqIn - llHdl->cqOut;
+		semGive( llHdl->windowPointerSemId );
 
-    DBGWRT_2((DBH, "LL - PROFIDP_SetStat: Set state to %02x\n", state ));
+		if ( avail >= reap->minNum )
+			break;
 
-	error=req_con( llHdl, DP, DP_ACT_PARAM_LOC, (u_int8 *)&ap,
-					 con_status );
-	return error;
+		elapsed = ((ACT_TICK - start) * 1000) / TICK_RATE;
+		if ( elapsed >= reap->timeout )
+			break;
+
+		OSS_SemWait( llHdl->osHdl, llHdl->cqSemP, (int32) (reap->timeout - elapsed) );
+	}
+
+	/* copy completions */
+	dst  = (u_int8*) (reap + 1);
+	rest = (u_int32) blk->size - sizeof(PROFIDP_ASYNC_REAP);
+
+	while ( 1 ) {
+		req = NULL;
+		semTake( llHdl->windowPointerSemId, WAIT_FOREVER );
+		if ( llHdl->cqOut != llHdl->cqIn ) {
+			req = &llHdl->pendReq[llHdl->cq[llHdl->cqOut % DP_MAX_PEND_REQ]];
+			if ( PROFIDP_ASYNC_CPL_SIZE( req->conLen ) <= rest )
+				llHdl->cqOut++;
+			else
+				req = NULL;
+		}
+		semGive( llHdl->windowPointerSemId );
+
+		if ( req == NULL )
+			break;
+
+		size = PROFIDP_ASYNC_CPL_SIZE( req->conLen );
+		cpl  = (PROFIDP_ASYNC_CPL*) dst;
+		cpl->tag   = req->tag;
+		cpl->error = req->error;
+		cpl->len   = req->conLen;
+		cpl->_pad  = 0;
+		OSS_MemCopy(llHdl->osHdl, sizeof(T_PROFI_SERVICE_DESCR), (char*) &req->sdb,
+					(char*) (cpl + 1));
+		OSS_MemCopy(llHdl->osHdl, req->conLen, (char*) req->conBuf,
+					(char*) (cpl + 1) + sizeof(T_PROFI_SERVICE_DESCR));
+
+		PROFIDP_pendReqFree( llHdl, req );
+
+		dst  += size;
+		rest -= size;
+		num++;
+	}
+
+	reap->num = num;
+
+	if ( num == 0 ) {
+		DBGWRT_ERR((DBH,"*** PROFIDP_asyncReap: No completion available\n"));
+		return (PROFIDP_ERR_NO_CON_IND);
+	}
+
+	return (ERR_SUCCESS);
 }
 
 /************************* PROFIDP_data_transfer **************************
@@ -2804,6 +5686,7 @@ static int16 PROFIDP_data_transfer (LL_HANDLE* llHdl, M_SG_BLOCK* blk) /* nodoc
 	int16      retVal;
 	u_int16   len;
 	T_DP_DATA_TRANSFER_CON*  dataTrans;
+	u_int8    conBuf[DP_MAX_TELEGRAM_LEN];
 
 
 	len = sizeof (T_DP_DATA_TRANSFER_CON);
@@ -2815,19 +5698,20 @@ static int16 PROFIDP_data_transfer (LL_HANDLE* llHdl, M_SG_BLOCK* blk) /* nodoc
 
 
 	if ( (retVal = req_con( llHdl, DP, DP_DATA_TRANSFER,
-    	                NULL, &status_ptr )) != 0)           {
+    	                NULL, &status_ptr, conBuf )) != 0)           {
 
 		DBGWRT_ERR((DBH,"*** PROFIDP_data_transfer: Error req_con error code = %04x\n",
 		                retVal));
 		return (retVal);
 	}
 
-	dataTrans = (T_DP_DATA_TRANSFER_CON*) llHdl->req_con_buf;
+	dataTrans = (T_DP_DATA_TRANSFER_CON*) conBuf;
 
 	DBGWRT_2((DBH, "LL - PROFIDP_data transfer: status = %04x diag_entries = %04x\n",
 	                dataTrans->status, dataTrans->diag_entries ));
 
-	OSS_MemCopy(llHdl->osHdl, (u_int32) blk->size, (char*) llHdl->req_con_buf, (char*) blk->data);
+	OSS_MemCopy(llHdl->osHdl, (u_int32) blk->size < sizeof (conBuf) ? (u_int32) blk->size : sizeof (conBuf),
+				(char*) conBuf, (char*) blk->data);
 
 
 	return ( 0 );
@@ -2856,6 +5740,7 @@ static int16 PROFIDP_get_slave_diag (LL_HANDLE* llHdl, M_SG_BLOCK* blk) /* nodoc
 	int16      retVal;
 	u_int16   len;
 	T_DP_GET_SLAVE_DIAG_CON*  diag;
+	u_int8    conBuf[DP_MAX_TELEGRAM_LEN];
 
 	len = sizeof (T_DP_GET_SLAVE_DIAG_CON);
 
@@ -2868,7 +5753,7 @@ static int16 PROFIDP_get_slave_diag (LL_HANDLE* llHdl, M_SG_BLOCK* blk) /* nodoc
 
 
 	if ( (retVal = req_con( llHdl, /* int mode, */ DP, DP_GET_SLAVE_DIAG,
-    	                NULL, &status_ptr )) != 0)           {
+    	                NULL, &status_ptr, conBuf )) != 0)           {
 
 		DBGWRT_ERR((DBH,"*** PROFIDP_get_salve_diag: Error req_con\n"));
 		return (retVal);
@@ -2876,69 +5761,373 @@ static int16 PROFIDP_get_slave_diag (LL_HANDLE* llHdl, M_SG_BLOCK* blk) /* nodoc
 
 	DBGWRT_3((DBH," PROFIDP_get_slave_diag: %d, %d, %d \n",llHdl->reqPending, llHdl->getSlaveDiagReqDelayed, llHdl->getSlaveDiagReqWaitCon ));
 
-	diag = (T_DP_GET_SLAVE_DIAG_CON*) llHdl->req_con_buf;
+	diag = (T_DP_GET_SLAVE_DIAG_CON*) conBuf;
 
 	DBGWRT_2((DBH, "LL - PROFIDP_data transfer: status = %04x diag_entries = %04x\n",
 	                diag->status, diag->diag_entries ));
 
 
-	OSS_MemCopy(llHdl->osHdl, (u_int32) blk->size, (char*) llHdl->req_con_buf, (char*) blk->data);
+	OSS_MemCopy(llHdl->osHdl, (u_int32) blk->size < sizeof (conBuf) ? (u_int32) blk->size : sizeof (conBuf),
+				(char*) conBuf, (char*) blk->data);
 
 	return ( 1 );
 }
 
+/**************************** PROFIDP_ch_list *****************************
+ *
+ *  Description:  Read or write the data of a list of channels (slaves)
+ *
+ *                blk->data holds an array of PROFIDP_CH_LIST_ITEM. The
+ *                whole list is transferred while the host semaphore of the
+ *                process image is held (allCh), so the list is consistent
+ *                and the semaphore handshake is done only once.
+ *
+ *---------------------------------------------------------------------------
+ *  Input......:  llHdl   low-level handle
+ *                blk     pointer to data structure M_SG_BLOCK
+ *                write   0=read inputs, 1=write outputs
+ *
+ *  Output.....:  return  success (0) or error code
+ *                        item.len returns the nbr of read bytes (read)
+ *  Globals....:  -
+ ****************************************************************************/
+
+static int32 PROFIDP_ch_list (LL_HANDLE* llHdl, M_SG_BLOCK* blk, u_int8 write) /* nodoc */
+{
+	PROFIDP_CH_LIST_ITEM *item = (PROFIDP_CH_LIST_ITEM*) blk->data;
+	u_int32   num = (u_int32) blk->size / sizeof(PROFIDP_CH_LIST_ITEM);
+	u_int32   n;
+	u_int8    ch;
+	u_int16   chLen;
+	u_int16   dataSize;
+	int32     error = ERR_SUCCESS;
+
+	DBGWRT_1((DBH, "LL - PROFIDP_ch_list: %s %d items\n",
+			  write ? "write" : "read", num));
+
+	if ( num == 0 || (u_int32) blk->size % sizeof(PROFIDP_CH_LIST_ITEM) ) {
+		DBGWRT_ERR((DBH," *** PROFIDP_ch_list: Illegal list size\n"));
+		return (ERR_LL_USERBUF);
+	}
+
+	/* check the whole list before accessing the DPRAM */
+	for ( n = 0; n < num; n++ ) {
+		ch = item[n].ch;
+
+		if ( ch >= DP_MAX_NUMBER_SLAVES || ch < llHdl->lowest_slave_address ) {
+			DBGWRT_ERR((DBH, " *** PROFIDP_ch_list: illegal channel %03d\n", ch));
+			return (ERR_LL_ILL_CHAN);
+		}
+
+		chLen = write ? llHdl->chInfo[ch].num_out : llHdl->chInfo[ch].num_in;
+
+		if ( !chLen ) {
+			DBGWRT_ERR((DBH, " *** PROFIDP_ch_list: channel %03d is no %s channel\n",
+							 ch, write ? "output" : "input"));
+			return (ERR_LL_ILL_CHAN);
+		}
+
+		if ( ((u_int32) item[n].offset + item[n].len) > chLen || item[n].buf == NULL ) {
+			DBGWRT_ERR((DBH, " *** PROFIDP_ch_list: illegal offset/len for channel %03d\n", ch));
+			return (ERR_LL_USERBUF);
+		}
+	}
+
+	/* write list to output shadow */
+	if ( write && llHdl->flushPeriod && llHdl->outShadow ) {
+		for ( n = 0; n < num; n++ ) {
+			ch = item[n].ch;
+			PROFIDP_outShadowWrite( llHdl,
+				(u_int32) (DP_ARRAY_OFFSET_OUT(ch) - DP_OUT_POINTER + item[n].offset),
+				item[n].len, item[n].buf );
+		}
+		return (ERR_SUCCESS);
+	}
+
+	/* hold host semaphore for the whole list */
+	llHdl->allCh = 1;
+
+	for ( n = 0; n < num; n++ ) {
+		ch       = item[n].ch;
+		dataSize = item[n].len;
+
+		if ( write ) {
+			if ( profi_set_data( llHdl, ID_DP_SLAVE_IO_IMAGE,
+								 (USIGN16) (DP_ARRAY_OFFSET_OUT(ch) + item[n].offset),
+								 dataSize, item[n].buf ) != E_OK ) {
+				DBGWRT_ERR((DBH, " *** PROFIDP_ch_list: set data ch %03d failed\n", ch));
+				error = PROFIDP_ERR_SET_DATA;
+				break;
+			}
+		}
+		else {
+			if ( profi_get_data( llHdl, ID_DP_SLAVE_IO_IMAGE,
+								 (USIGN16) (DP_ARRAY_OFFSET_IN(ch) + item[n].offset),
+								 &dataSize, item[n].buf ) != E_OK ) {
+				DBGWRT_ERR((DBH, " *** PROFIDP_ch_list: get data ch %03d failed\n", ch));
+				error = PROFIDP_ERR_GET_DATA;
+				break;
+			}
+			item[n].len = dataSize;
+		}
+	}
+
+	/* release host semaphore */
+	llHdl->allCh = 0;
+	cmi_release_data_descr( llHdl, ID_DP_SLAVE_IO_IMAGE );
+
+	if ( error )
+		return (error);
+
+	/* check if FW is still alive */
+	if( PROFIDP_aliveCheck( llHdl ) ) {
+		DBGWRT_ERR((DBH, " *** PROFIDP_ch_list: FW is not alive !!\n"));
+		return (PROFIDP_ERR_FW_NOT_ALIVE);
+	}
+
+	return (ERR_SUCCESS);
+}
+
 /************************* PROFIDP_inConIndBuffer **************************
  *
  *  Description:  Write one confirmation or indication into buffer
  *
+ *                Each record holds only the real length of the service
+ *                data. Records are not split, if a record does not fit at
+ *                the end of the buffer, the rest is marked unused.
+ *                Only the ISR-Task writes records (single producer).
+ *                When the buffer is full, con_ind_policy decides:
+ *                PROFIDP_CON_IND_DROP_NEWEST  record is lost
+ *                PROFIDP_CON_IND_DROP_OLDEST  oldest records are dropped
+ *                PROFIDP_CON_IND_BLOCK        not stored, the ISR-Task
+ *                                             queues it (conIndHeld)
+ *                Never waits, the caller holds the window pointer sem.
  *
  *---------------------------------------------------------------------------
  *  Input......:  llHdl   low-level handle
  *				  c_sdp   pointer to T_PROFI_SERVICE_DESCR
  *				  Buffer  pointer to CON/IND specific data
+ *				  len     length of CON/IND specific data
  *
- *  Output.....:  -
+ *  Output.....:  return  1: number of elements increased
+ *                        0: record lost or oldest record replaced
+ *                       -1: no space (policy block), record not stored
  *
  *  Globals....:  -
  ****************************************************************************/
 
-static void PROFIDP_inConIndBuffer ( LL_HANDLE* llHdl, T_PROFI_SERVICE_DESCR* c_sdb,
-                                     u_int8* Buffer ) /* nodoc */
+static int PROFIDP_inConIndBuffer ( LL_HANDLE* llHdl, T_PROFI_SERVICE_DESCR* c_sdb,
+                                    u_int8* Buffer, u_int16 len ) /* nodoc */
 
 {
+	CON_IND_REC_HDR *hdr;
+	u_int32 recSize, pos, rest, used;
+	int     dropped = 0;
+
 	IDBGWRT_1((DBH, ">>> PROFIDP_Irq: save CON/IND in buffer\n"));
 
-	/* save CON / IND in buffer if there is enough space */
-	if ( llHdl->con_ind_num_el * CON_IND_BUF_ELEMENT_SIZE >= llHdl->con_ind_buf_size ) {
+	if ( len > DP_MAX_TELEGRAM_LEN )
+		len = DP_MAX_TELEGRAM_LEN;
+	recSize = CON_IND_REC_SIZE( len );
+
+	/* make enough space */
+	while( 1 ) {
+		pos  = llHdl->con_ind_head % llHdl->con_ind_buf_size;
+		rest = llHdl->con_ind_buf_size - pos;
+		used = llHdl->con_ind_head - llHdl->con_ind_tail;
+
+		if ( used + (recSize > rest ? rest + recSize : recSize) <= llHdl->con_ind_buf_size )
+			break;
 
 		/* buffer overflow */
 		llHdl->con_ind_buf_full = 0x01;
-		return;
+
+		if ( llHdl->con_ind_policy == PROFIDP_CON_IND_BLOCK )
+			return -1;	/* not lost yet */
+
+		llHdl->con_ind_overflows++;
+
+		if ( llHdl->con_ind_policy == PROFIDP_CON_IND_DROP_OLDEST &&
+			 CON_IND_NUM_EL(llHdl) ) {
+			PROFIDP_dropConInd( llHdl );
+			dropped = 1;
+			continue;
+		}
+
+		return 0;
 	}
 
-	llHdl->con_ind_num_el++;
-	llHdl->con_ind_buf_full = 0;
+	/* record does not fit at end of buffer */
+	if ( recSize > rest ) {
+		hdr = (CON_IND_REC_HDR*) (llHdl->con_ind_buf + pos);
+		hdr->len = CON_IND_REC_WRAP;
+		llHdl->con_ind_head += rest;
+		pos = 0;
+	}
+
+	hdr = (CON_IND_REC_HDR*) (llHdl->con_ind_buf + pos);
+	hdr->len = len;
 
 	/* store service descriptor block */
 	OSS_MemCopy(llHdl->osHdl, sizeof (T_PROFI_SERVICE_DESCR), (char*) c_sdb,
-	   	        (char*) (llHdl->con_ind_buf_inP));
+	   	        (char*) (hdr + 1));
 
 	/* store service data */
-	OSS_MemCopy(llHdl->osHdl, DP_MAX_TELEGRAM_LEN, (char*) Buffer,
-	   	       (char*) (llHdl->con_ind_buf_inP + sizeof (T_PROFI_SERVICE_DESCR)));
+	OSS_MemCopy(llHdl->osHdl, len, (char*) Buffer,
+	   	       (char*) (hdr + 1) + sizeof (T_PROFI_SERVICE_DESCR));
+
+	/* publish record */
+	llHdl->con_ind_head += recSize;
+	llHdl->con_ind_in_cnt++;
+
+	if ( CON_IND_NUM_EL(llHdl) > llHdl->con_ind_hwm )
+		llHdl->con_ind_hwm = CON_IND_NUM_EL(llHdl);
+
+	if ( dropped )
+		return 0;
+
+	llHdl->con_ind_buf_full = 0;
+	return 1;
+}
+
+/************************ PROFIDP_conIndFlushHeld **************************
+ *
+ *  Description:  Move CON/INDs queued by the ISR-Task into CON/IND buffer
+ *
+ *                The records are stored in order as long as they fit
+ *                (policy block), with the drop policies all are stored
+ *                or lost. Must be called with the window pointer sem taken.
+ *
+ *---------------------------------------------------------------------------
+ *  Input......:  llHdl    low-level handle
+ *  Output.....:  -
+ *  Globals....:  -
+ ****************************************************************************/
+static void PROFIDP_conIndFlushHeld( LL_HANDLE* llHdl ) /* nodoc */
+{
+	CON_IND_HELD *held;
+	int stored;
+
+	while ( llHdl->conIndHeldCnt ) {
+		held   = &llHdl->conIndHeld[llHdl->conIndHeldRd];
+		stored = PROFIDP_inConIndBuffer( llHdl, &held->sdb, held->data, held->len );
+		if ( stored < 0 )
+			break;		/* still no space */
+
+		if ( stored )
+			OSS_SemSignal( llHdl->osHdl, llHdl->con_buf_semP );
+
+		llHdl->conIndHeldRd = (llHdl->conIndHeldRd + 1) % CON_IND_HELD_NUM;
+		llHdl->conIndHeldCnt--;
+	}
+}
+
+/*************************** PROFIDP_dropConInd ****************************
+ *
+ *  Description:  Remove oldest record from CON/IND buffer
+ *
+ *                Must be called with the window pointer semaphore taken,
+ *                the reader takes it too when policy is drop oldest.
+ *
+ *---------------------------------------------------------------------------
+ *  Input......:  llHdl   low-level handle
+ *  Output.....:  -
+ *  Globals....:  -
+ ****************************************************************************/
+static void PROFIDP_dropConInd ( LL_HANDLE* llHdl ) /* nodoc */
+{
+	CON_IND_REC_HDR *hdr;
+	u_int32 pos;
+
+	pos = llHdl->con_ind_tail % llHdl->con_ind_buf_size;
+	hdr = (CON_IND_REC_HDR*) (llHdl->con_ind_buf + pos);
+
+	if ( hdr->len == CON_IND_REC_WRAP ) {
+		llHdl->con_ind_tail += llHdl->con_ind_buf_size - pos;
+		hdr = (CON_IND_REC_HDR*) llHdl->con_ind_buf;
+	}
+
+	llHdl->con_ind_tail += CON_IND_REC_SIZE( hdr->len );
+	llHdl->con_ind_out_cnt++;
+}
 
-	llHdl->con_ind_buf_inP += CON_IND_BUF_ELEMENT_SIZE;
+/************************** PROFIDP_readConInd *****************************
+ *
+ *  Description:  Read oldest record out of CON/IND buffer
+ *
+ *                With withHdr set, the record is copied as stored
+ *                (PROFIDP_CON_IND_REC, service descr block, data, padding),
+ *                else only service descr block and data are copied.
+ *                The record stays in the buffer if it does not fit.
+ *
+ *---------------------------------------------------------------------------
+ *  Input......:  llHdl   low-level handle
+ *                dst     destination buffer
+ *                size    size of destination buffer
+ *                withHdr copy record header too
+ *
+ *  Output.....:  return  nbr of bytes copied, 0 = no element or no space
+ *  Globals....:  -
+ ****************************************************************************/
+static u_int32 PROFIDP_readConInd ( LL_HANDLE* llHdl, u_int8* dst, u_int32 size,
+                                    u_int8 withHdr ) /* nodoc */
+{
+	CON_IND_REC_HDR *hdr;
+	u_int32 pos, len;
+	u_int8  lock = (llHdl->con_ind_policy != PROFIDP_CON_IND_DROP_NEWEST);
+
+	/* ISR-Task may drop records, queued records are stored here (block) */
+	if ( lock && ERROR == semTake( llHdl->windowPointerSemId, WAIT_FOREVER ) ) {
+		DBGWRT_ERR((DBH," *** PROFIDP_readConInd: Error taking window pointer semaphore\n"));
+		return 0;
+	}
+
+	if ( CON_IND_NUM_EL(llHdl) == 0 ) {
+		if ( lock )
+			semGive( llHdl->windowPointerSemId );
+		return 0;
+	}
+
+	pos = llHdl->con_ind_tail % llHdl->con_ind_buf_size;
+	hdr = (CON_IND_REC_HDR*) (llHdl->con_ind_buf + pos);
+
+	if ( hdr->len == CON_IND_REC_WRAP ) {
+		llHdl->con_ind_tail += llHdl->con_ind_buf_size - pos;
+		hdr = (CON_IND_REC_HDR*) llHdl->con_ind_buf;
+	}
+
+	len = withHdr ? CON_IND_REC_SIZE( hdr->len ) :
+		            sizeof (T_PROFI_SERVICE_DESCR) + hdr->len;
 
-	if ( llHdl->con_ind_buf_inP >= ((u_int8*)(llHdl->con_ind_buf + llHdl->con_ind_buf_size)))
-		llHdl->con_ind_buf_inP = llHdl->con_ind_buf;
+	if ( len > size ) {
+		if ( lock )
+			semGive( llHdl->windowPointerSemId );
+		return 0;
+	}
+
+	/* read element from buffer */
+	OSS_MemCopy(llHdl->osHdl, len, withHdr ? (char*) hdr : (char*) (hdr + 1),
+			     (char*) dst );
+
+	/* release record */
+	llHdl->con_ind_tail += CON_IND_REC_SIZE( hdr->len );
+	llHdl->con_ind_out_cnt++;
 
+	if ( lock ) {
+		PROFIDP_conIndFlushHeld( llHdl );
+		semGive( llHdl->windowPointerSemId );
+	}
 
+	return len;
 }
 
 /************************ PROFIDP_outConIndBuffer **************************
  *
  *  Description:  Read one confirmation or indication out of buffer
  *
+ *                The user buffer gets T_PROFI_SERVICE_DESCR followed by
+ *                the service data, as before.
+ *
  *---------------------------------------------------------------------------
  *  Input......:  llHdl   low-level handle
  *				  blk     pointer to data structure
@@ -2956,114 +6145,95 @@ static int16 PROFIDP_outConIndBuffer ( LL_HANDLE* llHdl, M_SG_BLOCK* blk ) /* no
 
 	}
 
-	if ( llHdl->con_ind_num_el == 0 ) {
+	DBGWRT_2((DBH,"\nnumber of Elements in buffer = %04x", CON_IND_NUM_EL(llHdl)));
+
+	if ( PROFIDP_readConInd( llHdl, (u_int8*) blk->data, (u_int32) blk->size, 0 ) == 0 ) {
 		DBGWRT_ERR((DBH,"*** PROFIDP_outConIndBuffer: no element to read\n"));
 		return -1;
 	}
 
-	DBGWRT_2((DBH,"\nnumber of Elements in buffer = %04x", llHdl->con_ind_num_el));
-
-	/* read element from buffer */
-	OSS_MemCopy(llHdl->osHdl, CON_IND_BUF_ELEMENT_SIZE, (char*) llHdl->con_ind_buf_outP,
-			     ((char*) blk->data) );
-	llHdl->con_ind_num_el--;
-	llHdl->con_ind_buf_outP += CON_IND_BUF_ELEMENT_SIZE;
-
-	if ( llHdl->con_ind_buf_outP >= ((u_int8*)(llHdl->con_ind_buf + llHdl->con_ind_buf_size)))
-		llHdl->con_ind_buf_outP = llHdl->con_ind_buf;
-
 	if ( llHdl->con_ind_buf_full == 1 ) {
 		DBGWRT_ERR((DBH,"*** PROFIDP_outConIndBuffer: buffer overflow occured\n"));
 		return -1;
 	}
 
-	return ( llHdl->con_ind_num_el );
+	return ( (int16) CON_IND_NUM_EL(llHdl) );
 }
 
-
-
-/************************** waitForService_clear ***************************
+/************************ PROFIDP_outConIndMulti ***************************
  *
- *  Description:  Clear wait for service structure
+ *  Description:  Read as many CON/INDs out of buffer as fit into user buffer
  *
+ *                Waits max multi->timeout ms until multi->minNum records
+ *                are available. Each record taken out of the buffer also
+ *                takes one count of the CON/IND buffer semaphore.
  *
  *---------------------------------------------------------------------------
  *  Input......:  llHdl   low-level handle
+ *				  blk     PROFIDP_CON_IND_MULTI followed by space for records
  *
- *
- *  Output.....:  0: ok
- *
+ *  Output.....:  return  success (0) or error code
  *  Globals....:  -
  ****************************************************************************/
-static int8 waitForService_clear ( LL_HANDLE* llHdl ) /* nodoc */
+static int32 PROFIDP_outConIndMulti ( LL_HANDLE* llHdl, M_SG_BLOCK* blk ) /* nodoc */
 {
-	/* clear wait for Service structure */
-	llHdl->waitForService.comm_ref  = 0xffff;
-	llHdl->waitForService.layer     = 0xff;
-	llHdl->waitForService.service   = 0xff;
-	llHdl->waitForService.primitive = 0xff;
-	llHdl->waitForService.invoke_id = (PB_INT8) 0xff;
-	llHdl->waitForService.result    = (PB_INT16) 0xffff;
-
-	return (0);
-}
-
-/*************************** get_offs **************************************
- *
- *  Description: Get IN/OUTput offset of specific slave
- *
- *---------------------------------------------------------------------------
- *  Input......: llHdl		  low-level handle
- *               address      pointer to slave parameter length of specific slave
- *
- *  Output.....: sl_addr      slave address
- *               num_inputs   number of input bytes for slave
- *               num_outputs  number of output bytes for slave
- *               sl_para_len  length of slave parameter set
- *               return       memory address of next slave parameter set
- *
- *  Globals....: -
- ****************************************************************************/
-static u_int8* get_offs (LL_HANDLE* llHdl, u_int8* address, u_int8* sl_addr,
-                      u_int8* num_inputs, u_int8* num_outputs, u_int16* sl_para_len) /* nodoc */
-{
-	u_int8* start_addr;
-	u_int16 size;
-
-	start_addr = address;
-
-	*sl_addr = *address;
-	address++;
-	*sl_para_len = TWISTWORD(*((u_int16*) address));  /* read slave parameter data length */
-	DBGWRT_2((DBH, "PROFIDP_CONFIG get_offs: sl_para_len = %04x, address = %08p\n", *sl_para_len,
-	                address));
-
-	address += 16;   /* jump to prm_data */
-	size = TWISTWORD(*((u_int16*) address)); /* read prm_data size */
-	DBGWRT_2((DBH, "PROFIDP_CONFIG get_offs: prm_data size = %04x\n", size));
+	PROFIDP_CON_IND_MULTI *multi = (PROFIDP_CON_IND_MULTI*) blk->data;
+	u_int8  *dst;
+	u_int32 rest, got, start, elapsed;
+	u_int32 taken = 0;
+	u_int16 num = 0;
+
+	if ( blk->size < (int32) (sizeof(PROFIDP_CON_IND_MULTI) +
+							  CON_IND_REC_SIZE( DP_MAX_TELEGRAM_LEN )) ) {
+		DBGWRT_ERR((DBH,"*** PROFIDP_outConIndMulti: block size to small\n"));
+		return (ERR_LL_USERBUF);
+	}
 
-	address += size;              /* jump to cfg_data */
+	/* wait for minNum records */
+	start = ACT_TICK;
+	while ( CON_IND_NUM_EL(llHdl) < multi->minNum ) {
+		elapsed = ((ACT_TICK - start) * 1000) / TICK_RATE;
+		if ( elapsed >= multi->timeout ||
+			 OSS_SemWait( llHdl->osHdl, llHdl->con_buf_semP,
+						  (int32) (multi->timeout - elapsed) ) != 0 )
+			break;
+		taken++;
+	}
 
-	size = TWISTWORD(*((u_int16*) address)); /* read cfg_data size */
-	DBGWRT_2((DBH, "PROFIDP_CONFIG get_offs: cfg_data size = %04x\n", size));
+	/* copy records */
+	dst  = (u_int8*) (multi + 1);
+	rest = (u_int32) blk->size - sizeof(PROFIDP_CON_IND_MULTI);
+
+	while ( (got = PROFIDP_readConInd( llHdl, dst, rest, 1 )) != 0 ) {
+		if ( taken )
+			taken--;
+		else
+			OSS_SemWait( llHdl->osHdl, llHdl->con_buf_semP, OSS_SEM_NOWAIT );
+		dst  += got;
+		rest -= got;
+		num++;
+	}
 
-	address += size;              /* jump to aat_data, size was already twisted !*/
+	/* give back counts of records left in buffer */
+	for ( ; taken; taken-- )
+		OSS_SemSignal( llHdl->osHdl, llHdl->con_buf_semP );
 
-	size = TWISTWORD(*((u_int16*) address)); /* read aat_data size */
+	multi->num = num;
 
-	address += 2;    /* jump over aat_data size */
+	if ( num == 0 ) {
+		DBGWRT_ERR((DBH,"*** PROFIDP_outConIndMulti: No CON/IND available\n"));
+		return (PROFIDP_ERR_NO_CON_IND);
+	}
 
-	*num_inputs = *address;      /* read number of inputs */
-	address++;
-	DBGWRT_2((DBH, "PROFIDP_CONFIG get_offs: %04x Inputs\n", *num_inputs));
+	if ( llHdl->con_ind_buf_full == 1 ) {
+		DBGWRT_ERR((DBH,"*** PROFIDP_outConIndMulti: buffer overflow occured\n"));
+		return (PROFIDP_ERR_READ_CON_IND);
+	}
 
-	*num_outputs = *address;     /* read number of outputs */
-	address++;
-	DBGWRT_2((DBH, "PROFIDP_CONFIG get_offs: %04x Outputs\n", *num_outputs));
+	return (ERR_SUCCESS);
+}
 
-	return (start_addr + *sl_para_len + 1 /* jump over slave address*/);
 
-}
 
 /*************************** PROFIDP_copy_buspar ***************************
  *
@@ -3141,6 +6311,11 @@ static int16 PROFIDP_copy_buspar (u_int16 length, u_int8 *sourceP, u_int8 *desti
  *  DP_GET_SLAVE_DIAG. profi_snd_req_res_usr() therefore checks the
  *  getSlaveDiagReqWaitCon flag before sending a new request.
  *
+ *  All senders (driver calls, submission task, alive task and ISR-Task)
+ *  check the flags and write the mailbox with the window pointer
+ *  semaphore taken. The ACK is awaited after the semaphore is given,
+ *  the ISR-Task stores the result of the firmware in reqRetVal.
+ *
  *  If it is set, the irq does not send the request. Instead, it sets
  *  the flag getSlaveDiagReqDelayed in llHdl. After the service sent
  *  by profi_snd_req_res_usr has terminated the DP_GET_SLAVE_DIAG request
@@ -3150,20 +6325,17 @@ static int16 PROFIDP_copy_buspar (u_int16 length, u_int8 *sourceP, u_int8 *desti
  *  Input......: llHdl			low level handle
  *				 sdp_ptr		service descriptor pointer
  *				 data_ptr		service specific data
- *				 driverIntCon	confirmatin of req is handled driver internal
  *  Output.....: returns:		error code
  *  Globals....: -
  ****************************************************************************/
 static int16 profi_snd_req_res_usr(
 	LL_HANDLE     		  *llHdl,
 	T_PROFI_SERVICE_DESCR FAR *sdb_ptr,
-	VOID                  FAR *data_ptr,
-	PB_BOOL               driverIntCon
+	VOID                  FAR *data_ptr
 	) /* nodoc */
 {
 	int16 dpError;
 	u_int32 startTick;
-	u_int8 rsp_layer = (sdb_ptr->layer)==DP ? DP_USR : FMB_USR;
 
 
 	DBGWRT_3((DBH,"profi_snd_req_res_usr: Layer = 0x%02x\n", sdb_ptr->layer ));
@@ -3172,7 +6344,12 @@ static int16 profi_snd_req_res_usr(
 
 	/* check if irq routine is waiting for ACK from controller */
 	startTick = ACT_TICK;
-	while( llHdl->getSlaveDiagReqWaitCon || llHdl->reqPending ){
+	while( 1 ){
+		semTake( llHdl->windowPointerSemId, WAIT_FOREVER );
+		if( DP_SEND_IDLE( llHdl ) )
+			break;
+		semGive( llHdl->windowPointerSemId );
+
 		DBGWRT_2((DBH,"profi_snd_req_res_usr: wait for getSlaveDiagReqWaitCon=%d or reqPending=%d\n",
 		          llHdl->getSlaveDiagReqWaitCon, llHdl->reqPending ));
 		if ( (int32) (ACT_TICK - startTick) >= ((int32) (PROFIDP_CMI_TIMEOUT * TICK_RATE)) ) {
@@ -3182,16 +6359,15 @@ static int16 profi_snd_req_res_usr(
 		OSS_Delay( llHdl->osHdl, 1 );
 	}
 
+	/* send request to firmware, ACK is awaited below */
 	llHdl->reqPending = TRUE;	/* flag request is pending */
+	dpError = profi_snd_req_res( llHdl, sdb_ptr, data_ptr, FALSE );
+	if( dpError != E_OK )
+		llHdl->reqPending = FALSE;
+	semGive( llHdl->windowPointerSemId );
 
-	if( driverIntCon ) {
-		/* set up wait for service structure */
-		llHdl->waitForService.layer     = rsp_layer;
-		llHdl->waitForService.service   = sdb_ptr->service;
-		llHdl->waitForService.primitive = CON;
-	}
-	/* send request to firmware, wait for ACK */
-	dpError = profi_snd_req_res( llHdl, sdb_ptr, data_ptr, TRUE );
+	if( dpError == E_OK )
+		dpError = cmi_wait_ack( llHdl );
 
 	return dpError;
 }
@@ -3240,6 +6416,7 @@ static void PROFIDP_sendDiagReqIrq(LL_HANDLE *llHdl) /* nodoc */
 
 	IDBGWRT_2((DBH," Request next diag...\n"));
 	diagPsd.comm_ref	= 0;
+	diagPsd.invoke_id	= 0;	/* not used by pending requests */
 	diagPsd.layer 		= DP;
 	diagPsd.service 	= DP_GET_SLAVE_DIAG;
 	diagPsd.primitive	= REQ;
@@ -3268,10 +6445,10 @@ static void PROFIDP_sendDiagReqIrq(LL_HANDLE *llHdl) /* nodoc */
 
 /***************************** PROFIDP_aliveCheck ****************************
  *
- *  Description: In cyclic data transfer mode this functin checks if the
- *               PROFIDP-FW is still alive. This is done by sending a
- *               get slave diag request to FW and checking if a confirmation
- *               occurs for this service.
+ *  Description: Return result of the firmware alive check
+ *
+ *               The check is done by PROFIDP_AliveTask in the background,
+ *               I/O calls only read the result.
  *
  *---------------------------------------------------------------------------
  *  Input......: llHdl			low level handle
@@ -3282,76 +6459,168 @@ static void PROFIDP_sendDiagReqIrq(LL_HANDLE *llHdl) /* nodoc */
  ****************************************************************************/
 static int32 PROFIDP_aliveCheck(LL_HANDLE *llHdl) /* nodoc */
 {
-	int32          error            = 0;
-
-	/* alive check is only done in cyclic mode */
-	if( llHdl->cyclicDataTransfer ) {
-
-		switch( llHdl->aliveState ) {
-
-			case PROFIDP_ALIVE_IDLE:
-				if( (((u_int32) ACT_TICK) - llHdl->lastAliveCheck) > ((u_int32) PROFIDP_ALIVE_CHECK_CYCLE) ) {
-					/* lock semaphore */
-					if( (OSS_SemWait( llHdl->osHdl, llHdl->fwAliveCheckSemP, OSS_SEM_NOWAIT ))
-					     == 0 ) {
-						DBGWRT_3((DBH," PROFIDP_aliveCheck: %d, %d, %d \n",llHdl->reqPending, llHdl->getSlaveDiagReqDelayed, llHdl->getSlaveDiagReqWaitCon ));
-						/* lock interrupts */
-						if( ERROR == semTake( llHdl->windowPointerSemId, WAIT_FOREVER ) ) {
-							DBGWRT_ERR((DBH," *** PROFIDP_aliveCheck: Error taking window pointer semaphore\n"));
-						}
+	return llHdl->fwAlive ? 0 : -1;
+}
 
-						if( !llHdl->reqPending && !llHdl->getSlaveDiagReqDelayed &&
-						    !llHdl->getSlaveDiagReqWaitCon ) {
-							DBGWRT_3((DBH," PROFIDP_aliveCheck: Send alive REQ \n" ));
-							/* send diag request for alive checking */
-							PROFIDP_sendDiagReqIrq( llHdl );
-							llHdl->lastFwDiagConInd = ACT_TICK;
-							llHdl->aliveState = PROFIDP_ALIVE_WAIT_CON;
-							/* set flag fwAliveCheckWait */
-							llHdl->fwAliveCheckWait = TRUE;
+/***************************** PROFIDP_aliveProbe ****************************
+ *
+ *  Description: Check exception image of the firmware
+ *
+ *               A task_id other than 0 in the exception image means the
+ *               firmware reported an exception. The data descriptor is
+ *               read once, a semaphore conflict or a missing exception
+ *               image counts as no exception.
+ *
+ *---------------------------------------------------------------------------
+ *  Input......: llHdl			low level handle
+ *
+ *  Output.....: returns:		0: no exception, -1: exception reported
+ *  Globals....: -
+ ****************************************************************************/
+static int32 PROFIDP_aliveProbe(LL_HANDLE *llHdl) /* nodoc */
+{
+	T_EXCEPTION exc;
+	USIGN16     size  = sizeof(exc);
+	int32       error = 0;
+
+	/* PROFIDP_Config clears dataDescrValid with semaphore taken */
+	taskSafe();
+	semTake( llHdl->windowPointerSemId, WAIT_FOREVER );
+	if( llHdl->dataDescrValid &&
+		cmi_get_data_descr( llHdl, ID_EXCEPTION_IMAGE, 0, &size, &exc ) == E_OK &&
+		size >= sizeof(exc) && exc.task_id != 0 ) {
+		DBGWRT_ERR((DBH, " *** PROFIDP_aliveProbe: FW exception task=%d "
+					"par=%02x %04x %04x\n", exc.task_id, exc.par1,
+					TWISTWORD(exc.par2), TWISTWORD(exc.par3)));
+		error = -1;
+	}
+	semGive( llHdl->windowPointerSemId );
+	taskUnsafe();
 
-						}
-						/* enable interrupts */
-						if( ERROR == semGive( llHdl->windowPointerSemId ) ) {
-							DBGWRT_ERR((DBH," *** PROFIDP_aliveCheck: Error giving window pointer semaphore\n"));
-						}
+	return error;
+}
 
+/**************************** PROFIDP_AliveTask ********************************
+ *
+ *  Description:  Firmware alive check task
+ *
+ *                Checks every ALIVE_CHECK_PERIOD ms if the firmware is
+ *                alive and publishes the result in llHdl->fwAlive. The
+ *                cheap checks come first: an exception in the exception
+ *                image means dead, CON/INDs received by the ISR-Task
+ *                since the last check mean alive. Only without any
+ *                traffic a DP_GET_SLAVE_DIAG request is sent, the firmware
+ *                is dead if no CON/IND arrives within PROFIDP_ALIVE_TIMEOUT.
+ *                The task waits on aliveSemP while the check is off, the
+ *                firmware is not configured or not in cyclic mode.
+ *                The request is sent under the send lock of all senders
+ *                (windowPointerSemId, DP_SEND_IDLE), task deletion is
+ *                deferred while the lock is held.
+ *
+ *---------------------------------------------------------------------------
+ *  Input......:  llHdl    low-level handle
+ *  Output.....:  return   void
+ *  Globals....:  ---
+ ****************************************************************************/
+static int PROFIDP_AliveTask(LL_HANDLE *llHdl)
+{
+	u_int32 activity = llHdl->fwActivity;
+
+	while( 1 ){
+		if( !llHdl->alivePeriod || !llHdl->cyclicDataTransfer ||
+			!llHdl->dataDescrValid ) {
+			llHdl->fwAlive = TRUE;
+			OSS_SemWait( llHdl->osHdl, llHdl->aliveSemP, OSS_SEM_WAITFOREVER );
+			activity = llHdl->fwActivity;
+			continue;
+		}
 
-						/* release semaphore */
-						if ((OSS_SemSignal( llHdl->osHdl, llHdl->fwAliveCheckSemP )) != 0) {
-							DBGWRT_ERR((DBH," *** PROFIDP_aliveCheck: Error signaling "
-											"alive semaphore\n"));
-						}
+		OSS_Delay( llHdl->osHdl, (int32) llHdl->alivePeriod );
 
-					}
-				}
-				break;
+		if( PROFIDP_aliveProbe( llHdl ) ) {
+			llHdl->fwAlive = FALSE;
+			continue;
+		}
 
-			case PROFIDP_ALIVE_WAIT_CON:
-				if( llHdl->fwAliveCheckWait == FALSE ) {
-					llHdl->aliveState = PROFIDP_ALIVE_IDLE;
-					llHdl->lastAliveCheck = ACT_TICK;
-					DBGWRT_3((DBH," PROFIDP_aliveCheck: Received alive CON \n" ));
-				}
-				else {
-					if( (((u_int32) ACT_TICK) - llHdl->lastFwDiagConInd) > ((u_int32) PROFIDP_ALIVE_TIMEOUT )) {
-						error = -1;
-					}
-				}
+		if( llHdl->fwActivity != activity ) {
+			activity = llHdl->fwActivity;
+			llHdl->fwAlive = TRUE;
+			continue;
+		}
 
-				break;
+		/* no traffic, send diag request (unless a request is pending),
+		   same send lock as profi_snd_req_res_usr() */
+		taskSafe();
+		semTake( llHdl->windowPointerSemId, WAIT_FOREVER );
+		if( llHdl->dataDescrValid && DP_SEND_IDLE( llHdl ) &&
+			!llHdl->getSlaveDiagReqDelayed ) {
+			DBGWRT_3((DBH," PROFIDP_AliveTask: Send alive REQ \n" ));
+			PROFIDP_sendDiagReqIrq( llHdl );
+		}
+		semGive( llHdl->windowPointerSemId );
+		taskUnsafe();
 
-		} /* switch */
-		DBGWRT_2((DBH," PROFIDP_aliveCheck: lastFwDiagConInd = %ld, "
-		              "lastAliveCheck = %ld, aliveState = %d\n",
-		              llHdl->lastFwDiagConInd, llHdl->lastAliveCheck, llHdl->aliveState ));
+		OSS_Delay( llHdl->osHdl, PROFIDP_ALIVE_TIMEOUT );
 
-	} /* if */
+		llHdl->fwAlive = (llHdl->fwActivity != activity);
+		activity = llHdl->fwActivity;
+		if( !llHdl->fwAlive ) {
+			DBGWRT_ERR((DBH, " *** PROFIDP_AliveTask: FW is not alive !!\n"));
+		}
+	}
 
-	return error;
+	return 0;
 }
 
+/******************************** dp_time_us *******************************
+ *
+ *  Description: Get time for startup phase measurement
+ *
+ *               Lower 32 bit of dp_time64_us(), wraps after 71 minutes.
+ *               Only differences of the returned values are meaningful.
+ *
+ *---------------------------------------------------------------------------
+ *  Input......: llHdl      low-level handle
+ *  Output.....: return     time (us)
+ *  Globals....: -
+ ****************************************************************************/
+u_int32 dp_time_us( LL_HANDLE* llHdl )
+{
+	return (u_int32) dp_time64_us( llHdl );
+}
 
+/****************************** dp_time64_us *******************************
+ *
+ *  Description: Get time since system start
+ *
+ *               With switch PROFIDP_TIMESTAMP, the system tick count is
+ *               refined by the BSP timestamp timer. The timestamp timer
+ *               must restart with each system clock tick, as the usual
+ *               BSP timestamp drivers do. Without the switch, the
+ *               resolution is one system tick.
+ *
+ *               The time wraps with the 32 bit system tick counter
+ *               (497 days at 100 ticks/s).
+ *
+ *---------------------------------------------------------------------------
+ *  Input......: llHdl      low-level handle
+ *  Output.....: return     time (us)
+ *  Globals....: -
+ ****************************************************************************/
+u_int64 dp_time64_us( LL_HANDLE* llHdl )
+{
+#ifdef PROFIDP_TIMESTAMP
+	u_int32 tick, ts;
 
+	/* read again if a tick occurred meanwhile */
+	do {
+		tick = (u_int32) tickGet();
+		ts   = (u_int32) sysTimestamp();
+	} while ( tick != (u_int32) tickGet() );
 
-
+	return (u_int64) tick * 1000000 / sysClkRateGet() +
+		   (u_int64) ts * 1000000 / sysTimestampFreq();
+#else
+	return (u_int64) (u_int32) ACT_TICK * 1000000 / TICK_RATE;
+#endif
+}
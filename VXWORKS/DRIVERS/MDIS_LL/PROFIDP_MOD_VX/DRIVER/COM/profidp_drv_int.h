@@ -130,6 +130,8 @@
 #define DP_AUTO_START_ADDR_POINTER   0x400L     /* Address of auto start window in DPRAM */
 #define DP_AUTO_START_ADDR           0x18000L   /* Auto start address = address of firmware */
 
+#define CMI_MAX_DATA_DESCR  12          /* max entries of data descr list (128 byte window) */
+
 #define COMM_OFF	  0x8000			/* offset of CMI-descr. in DPRAM */
                                         /* CMI descriptor offset in DPRAM */
 #define COFF(cmi_var) \
@@ -142,15 +144,35 @@
 #define DP_ARRAY_OFFSET_OUT(ch)   (DP_OUT_POINTER + \
                                      ((ch - llHdl->lowest_slave_address) * llHdl->max_slave_output_len))
 
+#define DP_CHG_WORDS              4 /* u_int32 words of input change bitmap (128 bit) */
+#define DP_CONFLICT_HIST_NUM      5 /* see PROFIDP_CONFLICT_HIST_NUM */
+
+#define DP_FW_VERIFY_FULL         0 /* FW_VERIFY: compare all words */
+#define DP_FW_VERIFY_SAMPLED      1 /* FW_VERIFY: compare every DP_FW_VERIFY_STEP word */
+#define DP_FW_VERIFY_OFF          2 /* FW_VERIFY: no verification */
+#define DP_FW_VERIFY_STEP        32
+
+#define DP_CFG_BUS_PARA_MIN    0x42 /* min. bus_para_len of binary configuration */
+#define DP_CFG_SL_HDR_LEN        16 /* T_DP_SLAVE_PARA_SET without prm/cfg/aat/user data */
+#define DP_CFG_MAX_DL_LEN         (DP_MAX_TELEGRAM_LEN - sizeof(T_DP_DOWNLOAD_REQ))
+#define DP_CFG_WORD(p)            ((u_int16)(((p)[0] << 8) | (p)[1])) /* Motorola, unaligned */
+
+#define CON_IND_NUM_EL(llHdl)     ((llHdl)->con_ind_in_cnt - (llHdl)->con_ind_out_cnt)
+
+#define DP_DIAG_NO_SLOT        0xff /* diagSlot: slave not configured */
+#define DP_DIAG_ENTRY(llHdl,slot) \
+	((llHdl)->diagStore + (u_int32)(slot) * (llHdl)->diagEntrySize)
+
+#define DP_MAX_PEND_REQ          16 /* max nbr of requests waiting for CON */
+#define DP_MAX_ASYNC_REQ         (DP_MAX_PEND_REQ - 4) /* max submitted, rest kept for req_con() */
+#define DP_ASYNC_TIMEOUT       5000 /* max wait (ms) for CON of submitted request */
+
 
 #define ACT_TICK 			 (OSS_TickGet (llHdl->osHdl)) /* / OSS_TickRateGet (llHdl->osHdl)) */
 							/* get current system tick converted to sec */
 #define TICK_RATE			 OSS_TickRateGet (llHdl->osHdl)
 
-#define PROFIDP_ALIVE_CHECK_CYCLE  (2 * TICK_RATE)  /* check every 2s if FW is alive */
-#define PROFIDP_ALIVE_TIMEOUT      (1 * TICK_RATE)  /* FW alive timeout 1s */
-#define PROFIDP_ALIVE_IDLE         0  /* wait for next FW alive check cycle */
-#define PROFIDP_ALIVE_WAIT_CON     1  /* wait for CON of FW alive request (get diag req) */
+#define PROFIDP_ALIVE_TIMEOUT      1000 /* ms to wait for CON of FW alive request (get diag req) */
 
 /* replace D32 accesses with two D16 accesses */
 #if (defined(_BIG_ENDIAN_) && (!defined(MAC_BYTESWAP))) || ( defined(_LITTLE_ENDIAN_) && defined(MAC_BYTESWAP) )
@@ -184,28 +206,72 @@
 #define DP_ST_CLEAR				0x80
 #define DP_ST_OPERATE			0xc0
 
-
-
-/* this macro makes shure that the window-pointer can be resotored by IRQ-routine */
+/*--- startup phases timed in llHdl->tPhase (PROFIDP_BLK_STARTUP_TIME) ---*/
+#define DP_T_FW_VALIDATE		0	/* PROFIDP_Init */
+#define DP_T_FW_LOAD			1
+#define DP_T_FW_VERIFY			2
+#define DP_T_CMI_READY			3	/* PROFIDP_Config */
+#define DP_T_CMI_CONFIG_MODE	4
+#define DP_T_CMI_INIT			5
+#define DP_T_FMB_SET_CONFIG		6
+#define DP_T_INIT_MASTER		7
+#define DP_T_BUS_PARA_DL		8
+#define DP_T_SLAVE_PARA_DL		9
+#define DP_T_CONFIG				10
+#define DP_T_STACK_STOP			11	/* PROFIDP_START_STACK, one per dp_setstate */
+#define DP_T_STACK_CLEAR		12
+#define DP_T_STACK_OPERATE		13
+#define DP_T_NUM				14
+
+
+
+/*
+ * Window pointer handling
+ * llHdl->current_wptr holds the window wanted by the task level code and is
+ * restored by the IRQ-routine. llHdl->hw_wptr holds the window pointer
+ * currently set in hardware, DP_WPTR_INVALID if unknown (e.g. after
+ * accesses through the auto incrementing data port).
+ */
+#define DP_WPTR_INVALID		0xffffffffL		/* hw window pointer unknown */
+#define DP_WPTR_PAGE(x)		((x) & ~0x7fL)	/* 128 byte page of window */
+
+/* this macro makes shure that the window-pointer can be resotored by IRQ-routine.
+   The window pointer is only written if the 128 byte page changes */
 # define SET_WINDOW(base,x)	 \
 	{   \
-		if( llHdl->isrTaskId == taskIdSelf() ) { \
-			DP_SET_WINDOW(base,x); \
-		} \
-		else { \
-			DP_SET_WINDOW(base,x); \
+		if( llHdl->isrTaskId != taskIdSelf() ) \
 			llHdl->current_wptr = x; \
+		if( DP_WPTR_PAGE(llHdl->hw_wptr) != DP_WPTR_PAGE(x) ) { \
+			llHdl->hw_wptr = DP_WPTR_INVALID; \
+			DP_SET_WINDOW(base,x); \
+			llHdl->hw_wptr = x; \
 		} \
 	}
 
+/* set window pointer for data port accesses (0x80), the data port
+   increments the window pointer, so the hw window pointer gets unknown */
+# define SET_WINDOW_PORT(base,x)	 \
+	{   \
+		llHdl->hw_wptr = DP_WPTR_INVALID; \
+		DP_SET_WINDOW(base,x); \
+	}
+
+/* mailbox free for a new request, check with windowPointerSemId taken */
+#define DP_SEND_IDLE(llHdl) \
+	(!(llHdl)->reqPending && !(llHdl)->getSlaveDiagReqWaitCon)
+
 /*---- defs to make unique names for global symbols ----*/
 
 /* cmi.c */
 #define cmi_get_data_descr	PROFIDP_GLOBNAME(PROFIDP_VARIANT,cmi_get_data_descr)
+#define cmi_read_data_descr_list	PROFIDP_GLOBNAME(PROFIDP_VARIANT,cmi_read_data_descr_list)
+#define cmi_release_data_descr	PROFIDP_GLOBNAME(PROFIDP_VARIANT,cmi_release_data_descr)
 #define cmi_init			PROFIDP_GLOBNAME(PROFIDP_VARIANT,cmi_init)
+#define cmi_attach			PROFIDP_GLOBNAME(PROFIDP_VARIANT,cmi_attach)
 #define cmi_read			PROFIDP_GLOBNAME(PROFIDP_VARIANT,cmi_read)
 #define cmi_set_data_descr	PROFIDP_GLOBNAME(PROFIDP_VARIANT,cmi_set_data_descr)
 #define cmi_write			PROFIDP_GLOBNAME(PROFIDP_VARIANT,cmi_write)
+#define cmi_wait_ack		PROFIDP_GLOBNAME(PROFIDP_VARIANT,cmi_wait_ack)
 #define copy_from_dpram		PROFIDP_GLOBNAME(PROFIDP_VARIANT,copy_from_dpram)
 #define copy_to_dpram		PROFIDP_GLOBNAME(PROFIDP_VARIANT,copy_to_dpram)
 
@@ -219,10 +285,15 @@
 #define Firmware_Ident		PROFIDP_GLOBNAME(PROFIDP_VARIANT,Firmware_Ident)
 #define dp_fw				PROFIDP_GLOBNAME(PROFIDP_VARIANT,dp_fw)
 
+/* profidp_drv.c */
+#define dp_time_us			PROFIDP_GLOBNAME(PROFIDP_VARIANT,dp_time_us)
+#define dp_time64_us		PROFIDP_GLOBNAME(PROFIDP_VARIANT,dp_time64_us)
+
 /* pci.c */
 #define profi_end			PROFIDP_GLOBNAME(PROFIDP_VARIANT,profi_end)
 #define profi_get_data		PROFIDP_GLOBNAME(PROFIDP_VARIANT,profi_get_data)
 #define profi_init			PROFIDP_GLOBNAME(PROFIDP_VARIANT,profi_init)
+#define profi_attach		PROFIDP_GLOBNAME(PROFIDP_VARIANT,profi_attach)
 #define profi_rcv_con_ind	PROFIDP_GLOBNAME(PROFIDP_VARIANT,profi_rcv_con_ind)
 #define profi_rcv_con_ind_wait	PROFIDP_GLOBNAME(PROFIDP_VARIANT,profi_rcv_con_ind_wait)
 #define profi_set_data		PROFIDP_GLOBNAME(PROFIDP_VARIANT,profi_set_data)
@@ -238,22 +309,121 @@ typedef struct {
 	u_int8 num_out;
 	} CH_INFO;
 
-/* low-level handle */
+/* index entry of one slave parameter set in the binary configuration */
+typedef struct {
+	u_int32 offs;       /* offset of T_DP_SLAVE_PARA_SET in config data (0=no slave) */
+	u_int16 len;        /* slave_para_len */
+	u_int16 dlLen;      /* download length incl. alignment bytes */
+	u_int8  num_in;     /* number of input bytes */
+	u_int8  num_out;    /* number of output bytes */
+	} CFG_SLAVE;
+
+/* state of a module left running by PROFIDP_Exit (HOT_REATTACH) */
+#define DP_HOT_MAX_MOD		4		/* nbr of modules */
+typedef struct {
+	MACCESS ma;         /* module (0=entry free) */
+	u_int32 fwCrc;      /* CRC32 of running firmware */
+	u_int32 cfgHash;    /* hash of configuration */
+	u_int32 descCrc;    /* CRC32 of descriptor values used by the configuration */
+	u_int8  stackState; /* last state set by dp_setstate */
+	u_int8  _pad[3];
+	} DP_HOT_STATE;
+
+/* dirty byte range of one slave slot in output shadow */
+typedef struct {
+	u_int8  lo;         /* first dirty byte */
+	u_int8  hi;         /* last dirty byte + 1 (0=clean) */
+	} OUT_DIRTY;
+
+/* pending request, completed by the ISR-Task when its CON arrives */
+typedef struct {
+	u_int8          used;       /* slot allocated */
+	u_int8          done;       /* CON received */
+	u_int8          layer;      /* layer of expected CON */
+	u_int8          service;    /* service of expected CON */
+	PB_INT8         invoke_id;  /* invoke id of REQ, unique per slot */
+	u_int8          async;      /* submitted, completion goes to CQ */
+	u_int8          sent;       /* REQ sent, CON may arrive */
+	u_int8          _pad;
+	u_int16         comm_ref;   /* comm ref of REQ */
+	PB_INT16        result;     /* POS/NEG of CON */
+	u_int16         conLen;     /* length of CON data */
+	u_int16         reqLen;     /* async: length of REQ data */
+	u_int32         seq;        /* allocation order, oldest first */
+	u_int32         tag;        /* async: user tag */
+	int32           error;      /* async: error code of completion */
+	u_int32         sentTick;   /* async: tick when REQ was sent */
+	T_PROFI_SERVICE_DESCR sdb;  /* async: REQ until sent, then CON */
+	OSS_SEM_HANDLE* semP;       /* signaled when CON received */
+	u_int8          conBuf[DP_MAX_TELEGRAM_LEN]; /* CON data (async: REQ data until sent) */
+	} PEND_REQ;
+
+/* header of one record in CON/IND buffer, followed by
+   T_PROFI_SERVICE_DESCR and len bytes of service data
+   (same layout as PROFIDP_CON_IND_REC) */
+typedef struct {
+	u_int16 len;        /* length of service data, CON_IND_REC_WRAP = wrap */
+	u_int16 _pad;
+	} CON_IND_REC_HDR;
+
+#define CON_IND_REC_WRAP     0xffff  /* rest of buffer unused, continue at start */
+#define CON_IND_REC_SIZE(len) \
+	((sizeof(CON_IND_REC_HDR) + sizeof(T_PROFI_SERVICE_DESCR) + (len) + 3) & ~3)
+
+/* CON/IND queued by the ISR-Task while the CON/IND buffer is full (policy block) */
+#define CON_IND_HELD_NUM     4
+
+typedef struct {
+	T_PROFI_SERVICE_DESCR sdb;
+	u_int16 len;        /* length of service data */
+	u_int8  data[DP_MAX_TELEGRAM_LEN];
+	} CON_IND_HELD;
+
+/* host copy of one entry of the CMI data description list */
+typedef struct {
+	u_int8  id;         /* data description id (0=end of list) */
+	u_int8  _pad;
+	u_int16 size;       /* data block size */
+	u_int8  *addr;      /* corrected data block address in DPRAM */
+	} DATA_DESCR_ENTRY;
+
+/* low-level handle
+   Fields used on every call and by the ISR-Task are kept at the start,
+   large buffers only used by configuration or single services at the end. */
 typedef struct {
 	/* general */
     int32           memAlloc;		   /* size allocated for the handle */
     OSS_HANDLE      *osHdl;            /* oss handle */
     OSS_IRQ_HANDLE  *irqHdl;           /* irq handle */
+    OSS_SEM_HANDLE  *devSemP;          /* device semaphore (LL_LOCK_CALL) */
     DESC_HANDLE     *descHdl;          /* desc handle */
     MACCESS         ma;                /* hw access handle */
-	MDIS_IDENT_FUNCT_TBL idFuncTbl;	   /* id function table */
-	OSS_SEM_HANDLE* req_con_f0_semP;   /* pointer to semaphore handle */
-	OSS_SEM_HANDLE* req_con_0f_semP;   /* pointer to semaphore handle */
-	OSS_SEM_HANDLE* con_buf_semP;      /* pointer to semaphore handle */
-	OSS_SEM_HANDLE* fwAliveCheckSemP;  /* pointer to semaphore handle */
+    MACCESS         maDpram;           /* hw access handle for direct DPRAM access (A24) */
 	/* debug */
     u_int32           dbgLevel;		/* debug level */
 	DBG_HANDLE        *dbgHdl;      /* debug handle */
+	/* DPRAM window and access flags */
+	USIGN32				  current_wptr; /* current 128 byte dpram window  */
+	USIGN32				  hw_wptr;      /* window pointer set in hardware */
+	OSS_SEM_HANDLE*  	  isrTaskSemP;
+	TASK_ID               isrTaskId;
+	SEM_ID                windowPointerSemId;
+	OSS_SEM_HANDLE*       req_con_f0_semP;  /* pointer to semaphore handle */
+	OSS_SEM_HANDLE*       con_buf_semP;     /* pointer to semaphore handle */
+	u_int8                irqFlag;          /* flag is set while doing int routine */
+	u_int8                reqPending;       /* flag is set while waiting for ACK from firmware
+											   for user requests */
+	u_int8                reqRetVal;        /* H_RET_VAL of user request, got at ACK */
+	u_int8				  getSlaveDiagReqDelayed; /* irq routine sets this flag when DP_GET_SLAVE_DIAG req delayed */
+	u_int8				  getSlaveDiagReqWaitAck; /* this flag is sets while waiting for DP_GET_SLAVE_DIAG
+												     req ACK */
+	u_int8				  getSlaveDiagReqWaitCon; /* this flag is sets while waiting for DP_GET_SLAVE_DIAG
+												     req CON */
+	u_int8                allCh;            /* flag to hold DPRAM semaphor */
+	u_int8                intFlagReq;       /* Interrupt flag to ack requests. Set to 0 if IRQ occured */
+	volatile u_int8       fwAlive;          /* result of alive task, read by I/O calls */
+	volatile u_int32      fwActivity;       /* nbr of CON/INDs received by the ISR-Task */
+	OSS_SEM_HANDLE* pendReqFreeSemP;   /* counts free pending request slots */
 	/* misc */
     u_int32           irqCount;        /* interrupt counter */
     u_int32           idCheck;		   /* id check enabled */
@@ -269,6 +439,17 @@ typedef struct {
 	u_int32			  autoRemoteService;   /* automaticaly respond to M2 services */
 	u_int32			  cyclicDataTransfer;   /* set cyclic data transfer state */
 	u_int32           masterClass2;         /* use master class 2 functionality */
+	u_int32           dpramDirect;          /* access DPRAM directly via A24 space */
+	u_int32           fwVerify;             /* verification mode DP_FW_VERIFY_xxx */
+	u_int32           fwSkipLoaded;         /* don't load identical firmware */
+	u_int32           fwCrc;                /* CRC32 of firmware image */
+	u_int8            fwPacked;             /* segment data of dp_fw is packed */
+	u_int32           hotReattach;          /* keep firmware running on exit, re-attach on init */
+	u_int32           cfgHashDesc;          /* expected configuration hash (CONFIG_HASH) */
+	u_int32           cfgHash;              /* hash of current configuration (0=none) */
+	u_int32           descCrc;              /* CRC32 of descriptor values used by the configuration */
+	u_int8            reattached;           /* Init re-attached to running firmware */
+	u_int8            stackState;           /* last state set by dp_setstate */
 	/* static variables from cmi.c */
 	T_CMI_DESCRIPTOR      *Wcmi;
 	u_int32			      c_base_address;
@@ -280,63 +461,145 @@ typedef struct {
 	VOID                  *c_data_ptr;
 	USIGN16               data_block_size;
 	USIGN16               param_block_size;
-	USIGN32				  current_wptr; /* current 128 byte dpram window  */
-	u_int8                req_con_buf[DP_MAX_TELEGRAM_LEN];	 /* buffer for REQ/CON data */
-	u_int8                con_buf[DP_MAX_TELEGRAM_LEN];	 /* buffer for CON data */
+	DATA_DESCR_ENTRY      dataDescr[CMI_MAX_DATA_DESCR]; /* host copy of data descr list */
+	u_int8                dataDescrNum;     /* number of entries in dataDescr */
+	u_int8                dataDescrValid;   /* dataDescr read after cmi_init */
 	u_int32               cTick_cmi_init;
 	u_int32               cTick_irq_to;
-	u_int32               cTick_pb_set_get_data;
-	u_int8                intFlagReq;       /* Interrupt flag to ack requests. Set to 0 if IRQ occured */
-	T_PROFI_SERVICE_DESCR waitForService;
-	u_int8                diagBuf[DP_MAX_NUMBER_SLAVES] [DP_MAX_TELEGRAM_LEN]; /*slave diag buffer */
+	/* data descriptor semaphore conflicts */
+	u_int32               conflictTimeout;  /* max wait (ms) */
+	u_int32               conflictSpin;     /* retries before backing off */
+	u_int32               conflictCnt;      /* nbr of accesses delayed */
+	u_int32               conflictTimeouts; /* nbr of accesses timed out */
+	u_int32               conflictMaxWait;  /* longest wait (ms) */
+	u_int32               conflictHist[DP_CONFLICT_HIST_NUM]; /* nbr of waits per range */
+	PEND_REQ              pendReq[DP_MAX_PEND_REQ]; /* requests waiting for CON */
+	u_int32               pendReqSeq;       /* allocation counter */
+	/* submission/completion queue of async requests (slot indices) */
+	u_int8                sq[DP_MAX_PEND_REQ];
+	u_int32               sqIn;
+	u_int32               sqOut;
+	u_int8                cq[DP_MAX_PEND_REQ];
+	u_int32               cqIn;
+	u_int32               cqOut;
+	OSS_SEM_HANDLE*       sqSemP;           /* counts entries of SQ */
+	OSS_SEM_HANDLE*       cqSemP;           /* signaled on new completion */
+	TASK_ID               sqTaskId;
 	/* CON/IND buffer */
 	u_int8*               con_ind_buf;
 	u_int32               con_ind_buf_size;   /* buffer size of CON/IND buffer */
-	u_int8*               con_ind_buf_inP;    /* in pointer of CON/IND buffer */
-	u_int8*               con_ind_buf_outP;
-	u_int8                con_ind_num_el;
+	volatile u_int32      con_ind_head;       /* bytes written (ISR-Task, except block) */
+	volatile u_int32      con_ind_tail;       /* bytes read (reader, except drop oldest) */
+	volatile u_int32      con_ind_in_cnt;     /* records written */
+	volatile u_int32      con_ind_out_cnt;    /* records read or dropped */
 	u_int8                con_ind_buf_full;   /* flag is set to 0x01 if buffer is full */
+	u_int32               con_ind_policy;     /* overflow policy PROFIDP_CON_IND_xxx */
+	u_int32               con_ind_overflows;  /* nbr of lost records */
+	u_int32               con_ind_hwm;        /* max nbr of records in buffer */
+	/* CON/IND queued while buffer full (policy block), window pointer sem */
+	CON_IND_HELD          conIndHeld[CON_IND_HELD_NUM];
+	u_int8                conIndHeldRd;     /* oldest queued record (0..CON_IND_HELD_NUM-1) */
+	u_int8                conIndHeldCnt;    /* nbr of queued records */
 	u_int32               con_ind_memSize;    /* returned mem size of OSS_Memget */
 	CH_INFO               chInfo[DP_MAX_NUMBER_SLAVES]; /* info structure for channels channel = slave address */
 	u_int8                max_slave_output_len;    /* max slave output len */
 	u_int8                max_slave_input_len;     /* max slave input len */
 	u_int8                lowest_slave_address;    /* lowest slave address */
-	u_int8                chDiag[(DP_MAX_NUMBER_SLAVES + 1)][DP_MAX_TELEGRAM_LEN]; /* diag entries for each channel */
-	u_int8                irqFlag;          /* flag is set while doing int routine */
-	u_int8                reqPending;       /* flag is set while waiting for ACK from firmware
-											   for user requests */
-	u_int8				  getSlaveDiagReqDelayed; /* irq routine sets this flag when DP_GET_SLAVE_DIAG req delayed */
-	u_int8				  getSlaveDiagReqWaitAck; /* this flag is sets while waiting for DP_GET_SLAVE_DIAG
-												     req ACK */
-	u_int8				  getSlaveDiagReqWaitCon; /* this flag is sets while waiting for DP_GET_SLAVE_DIAG
-												     req CON */
-	u_int8                allCh;            /* flag to hold DPRAM semaphor */
-	u_int8				  _pad[3];
+	u_int16               max_slave_para_len;      /* max slave para len set by FMB (0=not configured) */
+	/* slave diag store, built by PROFIDP_Config */
+	u_int8*               diagStore;        /* one entry per configured slave */
+	u_int32               diagMemSize;      /* returned mem size of OSS_Memget */
+	u_int16               diagEntrySize;    /* size of one entry */
+	u_int8                diagSlot[DP_MAX_NUMBER_SLAVES + 1]; /* entry per address, DP_DIAG_NO_SLOT=none */
+	u_int32               diagBits[DP_CHG_WORDS]; /* new diag since last query, bit = slave address */
+	/* slave diag history (PROFIDP_DIAG_REC) */
+	u_int8*               diagHist;         /* ring of diagHistNum records */
+	u_int32               diagHistMemSize;  /* returned mem size of OSS_Memget */
+	u_int32               diagHistNum;      /* nbr of records (DIAG_HISTORY) */
+	u_int32               diagHistSeq;      /* records written (seq of next record) */
+	u_int32               diagHistRd;       /* oldest unread record (0..diagHistNum-1) */
+	u_int32               diagHistCnt;      /* nbr of unread records */
 	u_int32               conIndTimeout;    /* timeout for PROFIDP_BLK_RCV_CON_IND_WAIT */
 	u_int8                master_default_address; /* address of profibus master */
 	u_int8                fm2EventReason;   /* actual fm2 event reason */
-	u_int8                aliveState;       /* alive state for FW alive checking */
-	u_int32               lastAliveCheck;   /* tick value of last alive check */
-	u_int32               lastFwDiagConInd; /* tick value of last alive message */
-	u_int8				  fwAliveCheckWait; /* wait for FW alive confirmation */
-	OSS_SEM_HANDLE*  	  isrTaskSemP;
-	TASK_ID               isrTaskId;
-	SEM_ID                windowPointerSemId;
+	/* firmware alive check */
+	u_int32               alivePeriod;      /* check period (ms), 0=off */
+	OSS_SEM_HANDLE*       aliveSemP;        /* wakes up alive task */
+	TASK_ID               aliveTaskId;
+	/* input snapshot */
+	u_int32               snapPeriod;       /* snapshot period (ms), 0=off */
+	u_int8*               snapBuf;          /* double buffer (2 * snapSize) */
+	u_int32               snapMemSize;      /* returned mem size of OSS_Memget */
+	u_int32               snapSize;         /* size of input area */
+	u_int32               snapSeq;          /* nbr of snapshots, buffer = snapSeq & 1 */
+	volatile u_int8       snapValid;        /* snapshot buffer valid */
+	u_int32               snapTick;         /* tick value of last snapshot */
+	OSS_SEM_HANDLE*       snapSemP;         /* wakes up snapshot task */
+	TASK_ID               snapTaskId;
+	/* input change-of-state */
+	u_int32               chgBits[DP_CHG_WORDS]; /* changed since last query, bit = slave address */
+	u_int8                chgSig;           /* send signal on input change */
+	OSS_SEM_HANDLE*       chgSemP;          /* locks change bitmap */
+	/* output shadow */
+	u_int32               flushPeriod;      /* flush period (ms), 0=off */
+	u_int8*               outShadow;        /* shadow of output area */
+	u_int32               outShadowMemSize; /* returned mem size of OSS_Memget */
+	u_int32               outShadowSize;    /* size of output area */
+	OUT_DIRTY             outDirty[DP_MAX_NUMBER_SLAVES]; /* dirty range per slave slot */
+	u_int8                outDirtyAny;      /* at least one slot dirty */
+	OSS_SEM_HANDLE*       outShadowSemP;    /* locks output shadow */
+	OSS_SEM_HANDLE*       flushSemP;        /* wakes up flush task */
+	TASK_ID               flushTaskId;
+	/* large buffers */
+	MDIS_IDENT_FUNCT_TBL idFuncTbl;	   /* id function table */
+	u_int8                req_con_buf[DP_MAX_TELEGRAM_LEN];	 /* buffer for REQ/CON data */
+	u_int8                con_buf[DP_MAX_TELEGRAM_LEN];	 /* buffer for CON data */
+	CFG_SLAVE             cfgIdx[DP_MAX_NUMBER_SLAVES]; /* slave index of config data (PROFIDP_Config) */
+	CFG_SLAVE             cfgIdxNew[DP_MAX_NUMBER_SLAVES]; /* index built while checking new config data */
+	u_int32               tPhase[DP_T_NUM]; /* startup phase times (us) */
+	u_int32               tSlaveDl[DP_MAX_NUMBER_SLAVES]; /* slave para set download times (us) */
+	u_int32               diagGen[DP_MAX_NUMBER_SLAVES];  /* nbr of diag changes per slave address */
+	/* live list (PROFIDP_BLK_LIVE_LIST) */
+	u_int32               liveGen;          /* nbr of changes */
+	u_int32               liveBits[DP_CHG_WORDS]; /* last live bitmap */
+	u_int32               liveDiag[DP_CHG_WORDS]; /* last diag bitmap */
 
 	} LL_HANDLE;
 
 #include <MEN/ll_entry.h>      /* low-level driver jump table  */
 #include <MEN/profidp_mod_vx_drv.h>   /* PROFIDP driver header file */
 #include "m57segm.h"        /* segment structure for firmware */
+#include "m57pcfg.h"        /* precompiled configuration      */
 #include "m57_firm.h"       /* firmware data array            */
 
 /* include files which need LL_HANDLE */
 #include "cmi.h"               /* CMI sructure and prototypes for cmi.c */
 #include "pci.h"               /* prototypes for pci.h */
 
+/*-----------------------------------------+
+|  TYPEDEFS (need m57segm.h)               |
++-----------------------------------------*/
+#define FW_CHUNK                 64 /* words per firmware read */
+
+/* reader for (packed) firmware segment data */
+typedef struct {
+	const u_int8*   src;        /* next byte of segment data */
+	u_int8          packed;     /* segment data packed */
+	u_int8          tok;        /* current token */
+	u_int8          left;       /* words left of current token */
+	u_int8          _pad;
+	u_int16         word;       /* word of repeat token */
+	u_int16         dist;       /* distance of copy token */
+	u_int32         pos;        /* nbr of unpacked words */
+	u_int16         hist[M57_PACK_WINDOW]; /* last unpacked words */
+	} FW_STREAM;
+
 /*-----------------------------------------+
 |  PROTOTYPES                              |
 +-----------------------------------------*/
+/* profidp_drv.c */
+extern u_int32 dp_time_us( LL_HANDLE* llHdl );
+extern u_int64 dp_time64_us( LL_HANDLE* llHdl );
 
 
 #ifdef __cplusplus
@@ -0,0 +1,328 @@
+/****************************************************************************
+ ************                                                    ************
+ ************                   M57_CFGPACK                      ************
+ ************                                                    ************
+ ****************************************************************************
+ *
+ *       Author: ag
+ *
+ *  Description: Host tool to create a precompiled PROFIBUS configuration
+ *
+ *               Reads the binary configuration of the Softing
+ *               DP-Configurator and writes the precompiled configuration
+ *               described in m57pcfg.h. The driver accepts both with
+ *               PROFIDP_BLK_CONFIG. With the precompiled one it only
+ *               sends the prepared download requests.
+ *
+ *               This is a host program, it does not use MDIS:
+ *                 cc -o m57_cfgpack m57_cfgpack.c
+ *                 m57_cfgpack m57_test.bin m57_test.pcf
+ *
+ *     Required: -
+ *     Switches: -
+ *
+ *---------------------------------------------------------------------------
+ * (c) Copyright 2000 by MEN mikro elektronik GmbH, Nuernberg, Germany
+ ****************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef unsigned char  u_int8;
+typedef unsigned short u_int16;
+typedef unsigned int   u_int32;
+
+#include "../../../DRIVER/COM/m57pcfg.h"
+
+/*--------------------------------------+
+|   DEFINES                             |
++--------------------------------------*/
+/* same values as in driver, see pb_dp.h and profidp_drv_int.h */
+#define DP_MAX_TELEGRAM_LEN			244
+#define DP_MAX_DOWNLOAD_DATA_LEN	240
+#define DP_AREA_BUS_PARAM			0x7f
+#define DL_HDR_LEN					6		/* T_DP_DOWNLOAD_REQ */
+#define BUS_PARA_MIN				0x42	/* min. bus_para_len */
+#define SL_HDR_LEN					16		/* T_DP_SLAVE_PARA_SET header */
+
+#define GET16(p)	((u_int16)(((p)[0] << 8) | (p)[1]))
+
+/*--------------------------------------+
+|   PROTOTYPES                          |
++--------------------------------------*/
+static void put16( u_int8 *p, u_int32 v );
+static void put32( u_int8 *p, u_int32 v );
+static u_int32 add_dl( u_int8 *dst, u_int8 rem_add, u_int8 area,
+					   const u_int8 *src, u_int32 len, int align );
+static u_int32 crc32( const u_int8 *p, u_int32 len );
+
+/********************************* main ************************************
+ *
+ *  Description: Program main function
+ *
+ *---------------------------------------------------------------------------
+ *  Input......: argc,argv	argument counter, data ..
+ *  Output.....: return	    success (0) or error (1)
+ *  Globals....: -
+ ****************************************************************************/
+int main( int argc, char *argv[] )
+{
+	FILE *fp;
+	u_int8 *in, *out, *p;
+	long inSize;
+	u_int32 pos, end, sub, subLen, len, dlLen, outPos, maxSlParaLen = 0;
+	u_int32 nSub, addr, numDl = 0;
+	u_int8 masterAddr, lowest = 0xff, maxIn = 0, maxOut = 0, numIn, numOut;
+	u_int8 seen[M57_PCFG_NUM_SLAVES];
+	M57_PCFG_HDR *hdr;
+
+	if( argc != 3 ){
+		fprintf( stderr, "usage: m57_cfgpack <config.bin> <config.pcf>\n" );
+		return 1;
+	}
+
+	/*--- read binary configuration ---*/
+	if( (fp = fopen( argv[1], "rb" )) == NULL ){
+		perror( argv[1] );
+		return 1;
+	}
+	fseek( fp, 0, SEEK_END );
+	inSize = ftell( fp );
+	fseek( fp, 0, SEEK_SET );
+	in = malloc( inSize + 1 );
+	/* each block grows max. by download header, alignment and padding */
+	out = calloc( 1, sizeof(M57_PCFG_HDR) + 2 * inSize + 1024 );
+	if( in == NULL || out == NULL ||
+		fread( in, 1, inSize, fp ) != (size_t)inSize ){
+		fprintf( stderr, "*** can't read %s\n", argv[1] );
+		return 1;
+	}
+	fclose( fp );
+
+	/*--- bus parameter set ---*/
+	len = inSize >= BUS_PARA_MIN ? GET16( in ) : 0;
+	if( len < BUS_PARA_MIN || len > (u_int32)inSize ||
+		len > DP_MAX_TELEGRAM_LEN - DL_HDR_LEN ){
+		fprintf( stderr, "*** %s: bad bus parameter set\n", argv[1] );
+		return 1;
+	}
+	memset( seen, 0, sizeof(seen) );
+	hdr = (M57_PCFG_HDR*)out;
+	masterAddr = in[2];
+	memcpy( hdr->masterClass2Name, in + 34, sizeof(hdr->masterClass2Name) );
+
+	outPos = sizeof(M57_PCFG_HDR);
+	outPos += add_dl( out + outPos, masterAddr, DP_AREA_BUS_PARAM, in, len, 0 );
+	put16( (u_int8*)&hdr->maxBusParaLen, len );
+	numDl++;
+
+	/*--- slave parameter sets, checked as in driver ---*/
+	for( pos = len; inSize - pos > 4; pos = end ){
+		addr = in[pos++];
+		len  = GET16( in + pos );
+		end  = pos + len;
+
+		if( addr >= M57_PCFG_NUM_SLAVES || seen[addr] ){
+			fprintf( stderr, "*** bad/duplicate slave address %u at 0x%x\n",
+					 addr, pos - 1 );
+			return 1;
+		}
+		if( len < SL_HDR_LEN || end > (u_int32)inSize ){
+			fprintf( stderr, "*** slave %u: bad slave_para_len 0x%x\n", addr, len );
+			return 1;
+		}
+
+		dlLen  = len;
+		nSub   = 0;
+		numIn  = 0;
+		numOut = 0;
+		for( sub = pos + SL_HDR_LEN; sub < end; sub += subLen ){
+			subLen = (end - sub < 2) ? 0 : GET16( in + sub );
+			if( subLen < 2 || subLen > end - sub ){
+				fprintf( stderr, "*** slave %u: bad data block length at 0x%x\n",
+						 addr, sub );
+				return 1;
+			}
+			if( nSub == 2 && subLen >= 4 ){		/* aat_data */
+				numIn  = in[sub + 2];
+				numOut = in[sub + 3];
+			}
+			dlLen += subLen & 1;
+			nSub++;
+		}
+		if( nSub < 3 || dlLen > DP_MAX_TELEGRAM_LEN - DL_HDR_LEN ){
+			fprintf( stderr, "*** slave %u: bad parameter set\n", addr );
+			return 1;
+		}
+
+		seen[addr] = 1;
+		hdr->chInfo[addr][0] = numIn;
+		hdr->chInfo[addr][1] = numOut;
+
+		if( addr < lowest )
+			lowest = (u_int8)addr;
+		if( numIn > maxIn )
+			maxIn = numIn;
+		if( numOut > maxOut )
+			maxOut = numOut;
+		if( len > maxSlParaLen )
+			maxSlParaLen = len;
+
+		outPos += add_dl( out + outPos, masterAddr, (u_int8)addr, in + pos, len, 1 );
+		numDl++;
+		printf( "slave %3u: in=%3u out=%3u para_len=%u download_len=%u\n",
+				addr, numIn, numOut, len, dlLen );
+	}
+	if( numDl == 1 ){
+		fprintf( stderr, "*** %s: no slave configured\n", argv[1] );
+		return 1;
+	}
+
+	/*--- header, values as calculated by driver ---*/
+	maxSlParaLen += 4;
+	if( maxSlParaLen > DP_MAX_DOWNLOAD_DATA_LEN )
+		maxSlParaLen = DP_MAX_DOWNLOAD_DATA_LEN;
+
+	put32( (u_int8*)&hdr->magic, M57_PCFG_MAGIC );
+	put16( (u_int8*)&hdr->version, M57_PCFG_VERSION );
+	put16( (u_int8*)&hdr->hdrLen, sizeof(M57_PCFG_HDR) );
+	put32( (u_int8*)&hdr->size, outPos );
+	put16( (u_int8*)&hdr->maxSlaveParaLen, maxSlParaLen );
+	hdr->masterAddr   = masterAddr;
+	hdr->lowestSlAddr = lowest;
+	hdr->maxInLen     = (u_int8)((maxIn + 1) & ~1);
+	hdr->maxOutLen    = (u_int8)((maxOut + 1) & ~1);
+	hdr->numDl        = (u_int8)numDl;
+
+	p = out + M57_PCFG_HASH_START;
+	put32( (u_int8*)&hdr->hash, crc32( p, outPos - M57_PCFG_HASH_START ) );
+
+	/*--- write precompiled configuration ---*/
+	if( (fp = fopen( argv[2], "wb" )) == NULL ){
+		perror( argv[2] );
+		return 1;
+	}
+	if( fwrite( out, 1, outPos, fp ) != outPos ){
+		fprintf( stderr, "*** can't write %s\n", argv[2] );
+		return 1;
+	}
+	fclose( fp );
+
+	printf( "%u slaves, %ld bytes -> %u bytes, hash 0x%08x\n",
+			numDl - 1, inSize, outPos, crc32( p, outPos - M57_PCFG_HASH_START ) );
+	return 0;
+}
+
+/********************************* put16 ***********************************
+ *
+ *  Description: Write big endian 16 bit value
+ *
+ *---------------------------------------------------------------------------
+ *  Input......: p		pointer to value
+ *               v		value
+ *  Output.....: -
+ *  Globals....: -
+ ****************************************************************************/
+static void put16( u_int8 *p, u_int32 v )
+{
+	p[0] = (u_int8)(v >> 8);
+	p[1] = (u_int8)v;
+}
+
+/********************************* put32 ***********************************
+ *
+ *  Description: Write big endian 32 bit value
+ *
+ *---------------------------------------------------------------------------
+ *  Input......: p		pointer to value
+ *               v		value
+ *  Output.....: -
+ *  Globals....: -
+ ****************************************************************************/
+static void put32( u_int8 *p, u_int32 v )
+{
+	p[0] = (u_int8)(v >> 24);
+	p[1] = (u_int8)(v >> 16);
+	p[2] = (u_int8)(v >> 8);
+	p[3] = (u_int8)v;
+}
+
+/********************************* add_dl **********************************
+ *
+ *  Description: Append one DP_DOWNLOAD_LOC request
+ *
+ *               With align, an alignment byte is inserted after each odd
+ *               prm/cfg/aat/user data block and slave_para_len is
+ *               corrected, as done by the driver's PROFIDP_copy_buspar.
+ *
+ *---------------------------------------------------------------------------
+ *  Input......: dst		buffer for request
+ *               rem_add	master address
+ *               area		area code (slave address or DP_AREA_BUS_PARAM)
+ *               src		parameter set
+ *               len		length of parameter set
+ *               align		insert alignment bytes
+ *  Output.....: return		nbr of bytes appended (even)
+ *  Globals....: -
+ ****************************************************************************/
+static u_int32 add_dl( u_int8 *dst, u_int8 rem_add, u_int8 area,
+					   const u_int8 *src, u_int32 len, int align )
+{
+	u_int8 *d = dst + DL_HDR_LEN;
+	u_int32 i, subLen;
+
+	if( align ){
+		memcpy( d, src, SL_HDR_LEN );
+		d += SL_HDR_LEN;
+		for( i = SL_HDR_LEN; i < len; i += subLen ){
+			subLen = GET16( src + i );
+			memcpy( d, src + i, subLen );
+			d += subLen;
+			if( subLen & 1 )
+				*d++ = 0x00;
+		}
+		len = (u_int32)(d - (dst + DL_HDR_LEN));
+		put16( dst + DL_HDR_LEN, len );		/* slave_para_len */
+	}
+	else {
+		memcpy( d, src, len );
+		d += len;
+	}
+
+	put16( dst, len );		/* data_len */
+	dst[2] = rem_add;
+	dst[3] = area;
+	put16( dst + 4, 0 );	/* add_offset */
+
+	if( (d - dst) & 1 )
+		*d++ = 0x00;
+	return (u_int32)(d - dst);
+}
+
+/********************************* crc32 ***********************************
+ *
+ *  Description: Calculate CRC32 (same as driver's crc_fw_segment)
+ *
+ *---------------------------------------------------------------------------
+ *  Input......: p		data
+ *               len	nbr of bytes
+ *  Output.....: return	CRC
+ *  Globals....: -
+ ****************************************************************************/
+static u_int32 crc32( const u_int8 *p, u_int32 len )
+{
+	static const u_int32 crcTab[16] = {
+		0x00000000, 0x1db71064, 0x3b6e20c8, 0x26d930ac,
+		0x76dc4190, 0x6b6b51f4, 0x4db26158, 0x5005713c,
+		0xedb88320, 0xf00f9344, 0xd6d6a3e8, 0xcb61b38c,
+		0x9b64c2b0, 0x86d3d2d4, 0xa00ae278, 0xbdbdf21c };
+	u_int32 crc = 0xffffffff;
+
+	while( len-- ){
+		crc ^= *p++;
+		crc = (crc >> 4) ^ crcTab[crc & 0xf];
+		crc = (crc >> 4) ^ crcTab[crc & 0xf];
+	}
+	return crc;
+}
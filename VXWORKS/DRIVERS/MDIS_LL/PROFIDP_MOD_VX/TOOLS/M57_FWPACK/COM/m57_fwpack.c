@@ -0,0 +1,286 @@
+/****************************************************************************
+ ************                                                    ************
+ ************                   M57_FWPACK                       ************
+ ************                                                    ************
+ ****************************************************************************
+ *
+ *       Author: ag
+ *
+ *  Description: Host tool to create m57_firm.c with packed firmware data
+ *
+ *               Reads the M57 firmware loadfile (dp_fw.bin), packs the
+ *               data of each segment as described in m57segm.h and
+ *               writes the C source of the dp_fw array. The driver
+ *               unpacks the segments while loading them.
+ *
+ *               This is a host program, it does not use MDIS:
+ *                 cc -o m57_fwpack m57_fwpack.c
+ *                 m57_fwpack dp_fw.bin ../../../DRIVER/COM/m57_firm.c
+ *
+ *     Required: -
+ *     Switches: -
+ *
+ *---------------------------------------------------------------------------
+ * (c) Copyright 2000 by MEN mikro elektronik GmbH, Nuernberg, Germany
+ ****************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef unsigned char  u_int8;
+typedef unsigned short u_int16;
+typedef unsigned int   u_int32;
+
+#include "../../../DRIVER/COM/m57segm.h"
+
+/*--------------------------------------+
+|   DEFINES                             |
++--------------------------------------*/
+#define MAX_SEGS	32
+
+/*--------------------------------------+
+|   PROTOTYPES                          |
++--------------------------------------*/
+static u_int32 get32( const u_int8 *p );
+static void put32( u_int8 *p, u_int32 v );
+static u_int32 pack_segment( const u_int8 *src, u_int32 words, u_int8 *dst );
+
+/********************************* main ************************************
+ *
+ *  Description: Program main function
+ *
+ *---------------------------------------------------------------------------
+ *  Input......: argc,argv	argument counter, data ..
+ *  Output.....: return	    success (0) or error (1)
+ *  Globals....: -
+ ****************************************************************************/
+int main( int argc, char *argv[] )
+{
+	FILE *fp;
+	u_int8 *in, *out;
+	long inSize;
+	u_int32 nSegs, n, i, pos;
+	u_int32 segOffs[MAX_SEGS], segLen[MAX_SEGS], segAddr[MAX_SEGS];
+
+	if( argc != 3 ){
+		fprintf( stderr, "usage: m57_fwpack <dp_fw.bin> <m57_firm.c>\n" );
+		return 1;
+	}
+
+	/*--- read loadfile ---*/
+	if( (fp = fopen( argv[1], "rb" )) == NULL ){
+		perror( argv[1] );
+		return 1;
+	}
+	fseek( fp, 0, SEEK_END );
+	inSize = ftell( fp );
+	fseek( fp, 0, SEEK_SET );
+	in = malloc( inSize );
+	/* packed data can't grow more than 1/128 + 1 byte per segment */
+	out = malloc( 2 * inSize + 1024 );
+	if( in == NULL || out == NULL ||
+		fread( in, 1, inSize, fp ) != (size_t)inSize ){
+		fprintf( stderr, "*** can't read %s\n", argv[1] );
+		return 1;
+	}
+	fclose( fp );
+
+	if( inSize < 4 || get32( in ) != SYNC_CODE ){
+		fprintf( stderr, "*** %s is no M57 loadfile\n", argv[1] );
+		return 1;
+	}
+
+	/*--- read segment table ---*/
+	for( nSegs = 0; ; nSegs++ ){
+		const u_int8 *seg = in + 4 + nSegs * sizeof(m57_segm);
+
+		if( nSegs == MAX_SEGS || seg + sizeof(m57_segm) > in + inSize ){
+			fprintf( stderr, "*** bad segment table\n" );
+			return 1;
+		}
+		if( get32( seg ) == 0 )
+			break;
+
+		segOffs[nSegs] = get32( seg );
+		segLen[nSegs]  = get32( seg + 4 );
+		segAddr[nSegs] = get32( seg + 8 );
+		if( (segLen[nSegs] & 1) || segOffs[nSegs] + segLen[nSegs] > (u_int32)inSize ){
+			fprintf( stderr, "*** bad segment %u\n", nSegs );
+			return 1;
+		}
+	}
+
+	/*--- pack segments ---*/
+	pos = 4 + (nSegs + 1) * sizeof(m57_segm);
+	memset( out, 0, pos );
+	put32( out, SYNC_CODE_PACKED );
+
+	for( n = 0; n < nSegs; n++ ){
+		u_int8 *seg = out + 4 + n * sizeof(m57_segm);
+
+		put32( seg,     pos );
+		put32( seg + 4, segLen[n] );
+		put32( seg + 8, segAddr[n] );
+		i = pack_segment( in + segOffs[n], segLen[n] / 2, out + pos );
+		printf( "segment %u: loadaddr=0x%08x length=%u packed=%u\n",
+				n, segAddr[n], segLen[n], i );
+		pos += i;
+	}
+
+	/*--- write C source ---*/
+	if( (fp = fopen( argv[2], "w" )) == NULL ){
+		perror( argv[2] );
+		return 1;
+	}
+
+	fprintf( fp,
+		"/*********************  P r o g r a m  -  M o d u l e ***********************\n"
+		" *\n"
+		" *         Name: m57_firm.c\n"
+		" *      Project: PROFIDP module driver (MDIS V4.x)\n"
+		" *\n"
+		" *       Author: ag\n"
+		" *\n"
+		" *  Description: Firmware data array and ident function\n"
+		" *\n"
+		" *               Generated by m57_fwpack, the segment data is packed\n"
+		" *               (see m57segm.h).\n"
+		" *\n"
+		" *     Required: -\n"
+		" *     Switches: -\n"
+		" *\n"
+		" *---------------------------------------------------------------------------\n"
+		" * (c) Copyright 2000 by MEN mikro elektronik GmbH, Nuernberg, Germany\n"
+		" ****************************************************************************/\n"
+		"\n"
+		"#include \"profidp_drv_int.h\"\t\t/* local prototypes */\n"
+		"\n"
+		"char* Firmware_Ident( void )  /* nodoc */\n"
+		"{\n"
+		"    return( \"PROFIDP - PROFIDP firmware data (dp_fw.bin, packed)\" );\n"
+		"}\n"
+		"\n"
+		"\n"
+		"/* dp_fw: %u+4 data bytes (dp_fw.bin %ld bytes packed) */\n"
+		"const /* char */ u_int8 dp_fw[] = {\n"
+		"/* size */\n"
+		"0x%02x,0x%02x,0x%02x,0x%02x,\n"
+		"/* data */\n",
+		pos, inSize,
+		(pos >> 24) & 0xff, (pos >> 16) & 0xff, (pos >> 8) & 0xff, pos & 0xff );
+
+	for( i = 0; i < pos; i++ )
+		fprintf( fp, "0x%02x%s", out[i],
+				 i == pos - 1 ? "};\n" : ((i & 15) == 15 ? ",\n" : "," ) );
+
+	fclose( fp );
+
+	printf( "%ld bytes packed to %u bytes\n", inSize, pos );
+	return 0;
+}
+
+/********************************* get32 ***********************************
+ *
+ *  Description: Read big endian 32 bit value
+ *
+ *---------------------------------------------------------------------------
+ *  Input......: p		pointer to value
+ *  Output.....: return	value
+ *  Globals....: -
+ ****************************************************************************/
+static u_int32 get32( const u_int8 *p )
+{
+	return ((u_int32)p[0] << 24) | ((u_int32)p[1] << 16) |
+		   ((u_int32)p[2] << 8) | p[3];
+}
+
+/********************************* put32 ***********************************
+ *
+ *  Description: Write big endian 32 bit value
+ *
+ *---------------------------------------------------------------------------
+ *  Input......: p		pointer to value
+ *               v		value
+ *  Output.....: -
+ *  Globals....: -
+ ****************************************************************************/
+static void put32( u_int8 *p, u_int32 v )
+{
+	p[0] = (u_int8)(v >> 24);
+	p[1] = (u_int8)(v >> 16);
+	p[2] = (u_int8)(v >> 8);
+	p[3] = (u_int8)v;
+}
+
+/****************************** pack_segment *******************************
+ *
+ *  Description: Pack data of one segment
+ *
+ *               Greedy: a repeat is taken if it is at least as long as the
+ *               longest copy within the last M57_PACK_WINDOW words, else
+ *               the copy, else the word is added to the literal run.
+ *
+ *---------------------------------------------------------------------------
+ *  Input......: src		segment data
+ *               words		nbr of words
+ *               dst		buffer for packed data
+ *  Output.....: return		nbr of packed bytes
+ *  Globals....: -
+ ****************************************************************************/
+static u_int32 pack_segment( const u_int8 *src, u_int32 words, u_int8 *dst )
+{
+	u_int8 *d = dst;
+	u_int8 *litTok = NULL;		/* token of open literal run */
+	u_int32 i = 0, k, rep, len, best, bestDist, dist;
+
+#define WORD(n)	((u_int32)((src[2*(n)] << 8) | src[2*(n)+1]))
+
+	while( i < words ){
+		/* repeat of current word */
+		for( rep = 1; i + rep < words && rep < M57_PACK_MAXREP &&
+				 WORD(i + rep) == WORD(i); rep++ )
+			;
+
+		/* longest copy from history */
+		best = 0;
+		bestDist = 0;
+		for( dist = 1; dist <= M57_PACK_WINDOW && dist <= i; dist++ ){
+			for( len = 0; i + len < words && len < M57_PACK_MAXREP &&
+					 WORD(i + len) == WORD(i - dist + len); len++ )
+				;
+			if( len > best ){
+				best = len;
+				bestDist = dist;
+			}
+		}
+
+		if( rep >= 2 && rep >= best ){
+			*d++ = (u_int8)(M57_PACK_RUN | (rep - 2));
+			*d++ = src[2*i];
+			*d++ = src[2*i+1];
+			i += rep;
+			litTok = NULL;
+		}
+		else if( best >= 2 ){
+			*d++ = (u_int8)(M57_PACK_COPY | (best - 2));
+			*d++ = (u_int8)(bestDist - 1);
+			i += best;
+			litTok = NULL;
+		}
+		else {
+			if( litTok == NULL || *litTok == M57_PACK_MAXLIT - 1 ){
+				litTok = d++;
+				*litTok = 0;
+			}
+			else
+				(*litTok)++;
+			for( k = 0; k < 2; k++ )
+				*d++ = src[2*i+k];
+			i++;
+		}
+	}
+
+#undef WORD
+	return (u_int32)(d - dst);
+}
@@ -968,6 +968,18 @@ typedef struct _T_DP_FM2_EVENT_IND
 #define DP_CON_IND_BUF_EL           DP_MAX_NUMBER_STATIONS
 #define CON_IND_BUF_ELEMENT_SIZE   (DP_MAX_TELEGRAM_LEN + sizeof( T_PROFI_SERVICE_DESCR))
 #define DP_ISR_TASK_PRIO            50
+#define DP_DPRAM_DIRECT             PB_FALSE /* use A08 window to access DPRAM */
+#define DP_INPUT_SNAPSHOT_PERIOD    0        /* ms, 0 = no input snapshot */
+#define DP_OUTPUT_FLUSH_PERIOD      0        /* ms, 0 = no output shadow */
+#define DP_DATA_CONFLICT_TIMEOUT    5000     /* ms, max wait for data descr semaphore */
+#define DP_DATA_CONFLICT_SPIN       16       /* retries before backing off */
+#define DP_CON_IND_POLICY           0        /* drop newest CON/IND on overflow */
+#define DP_FW_VERIFY                0        /* full readback of loaded firmware */
+#define DP_FW_SKIP_LOADED           PB_FALSE /* always load firmware */
+#define DP_HOT_REATTACH             PB_FALSE /* reset module on exit */
+#define DP_CONFIG_HASH              0        /* no expected configuration */
+#define DP_DIAG_HISTORY             64       /* records of slave diag history */
+#define DP_ALIVE_CHECK_PERIOD       2000     /* ms, 0 = no firmware alive check */
 /*--------------------------------------------------------------------------*/
 
 #endif /* __PB_DP__ */
@@ -51,11 +51,118 @@
 /*-----------------------------------------+
 |  TYPEDEFS                                |
 +-----------------------------------------*/
-/* none */
+/* list item for PROFIDP_BLK_GET_CH_LIST/PROFIDP_BLK_SET_CH_LIST */
+typedef struct {
+	u_int8   ch;          /* channel (slave address) */
+	u_int8   _pad;
+	u_int16  offset;      /* offset within slave data */
+	u_int16  len;         /* nbr of bytes (GET: returns nbr of read bytes) */
+	u_int16  _pad2;
+	void     *buf;        /* user buffer */
+} PROFIDP_CH_LIST_ITEM;
+
+/* header of PROFIDP_BLK_RCV_CON_IND_MULTI buffer, followed by the records */
+typedef struct {
+	u_int16  minNum;      /* wait for at least minNum records (0=don't wait) */
+	u_int16  num;         /* returns nbr of records in buffer */
+	u_int32  timeout;     /* max wait (ms) for minNum records */
+} PROFIDP_CON_IND_MULTI;
+
+/* record of PROFIDP_BLK_RCV_CON_IND_MULTI, followed by T_PROFI_SERVICE_DESCR
+   and len bytes of service data, padded to PROFIDP_CON_IND_REC_SIZE(len) */
+typedef struct {
+	u_int16  len;         /* length of service data */
+	u_int16  _pad;
+} PROFIDP_CON_IND_REC;
+
+#define PROFIDP_CON_IND_REC_SIZE(len) \
+	((sizeof(PROFIDP_CON_IND_REC) + sizeof(T_PROFI_SERVICE_DESCR) + (len) + 3) & ~3)
+
+/* header of PROFIDP_BLK_SUBMIT_REQ buffer, followed by T_PROFI_SERVICE_DESCR
+   and len bytes of service data */
+typedef struct {
+	u_int32  tag;         /* user tag, returned with the completion */
+	u_int16  len;         /* length of service data */
+	u_int16  _pad;
+} PROFIDP_ASYNC_REQ;
+
+/* header of PROFIDP_BLK_REAP_CPL buffer, followed by the completions */
+typedef struct {
+	u_int16  minNum;      /* wait for at least minNum completions (0=don't wait) */
+	u_int16  num;         /* returns nbr of completions in buffer */
+	u_int32  timeout;     /* max wait (ms) for minNum completions */
+} PROFIDP_ASYNC_REAP;
+
+/* completion of PROFIDP_BLK_REAP_CPL, followed by T_PROFI_SERVICE_DESCR of
+   the CON (result) and len bytes of CON data, padded to PROFIDP_ASYNC_CPL_SIZE(len) */
+typedef struct {
+	u_int32  tag;         /* user tag of request */
+	int32    error;       /* 0 or error code, e.g. PROFIDP_ERR_REQ_CON_TIMEOUT */
+	u_int16  len;         /* length of CON data */
+	u_int16  _pad;
+} PROFIDP_ASYNC_CPL;
+
+#define PROFIDP_ASYNC_CPL_SIZE(len) \
+	((sizeof(PROFIDP_ASYNC_CPL) + sizeof(T_PROFI_SERVICE_DESCR) + (len) + 3) & ~3)
+
+/* descriptor semaphore conflict statistics for PROFIDP_BLK_CONFLICT_STAT */
+#define PROFIDP_CONFLICT_HIST_NUM  5  /* wait time <1, <10, <100, <1000, >=1000 ms */
+typedef struct {
+	u_int32  count;       /* nbr of data accesses delayed by a conflict */
+	u_int32  timeouts;    /* nbr of data accesses failed after timeout */
+	u_int32  maxWait;     /* longest wait (ms) */
+	u_int32  hist[PROFIDP_CONFLICT_HIST_NUM]; /* nbr of waits per range */
+} PROFIDP_CONFLICT_STAT;
+
+/* startup phase times for PROFIDP_BLK_STARTUP_TIME, all values in us,
+   0 if the phase was not run (yet) */
+#define PROFIDP_STARTUP_SLAVES  125   /* entries of slaveDl (slave address) */
+typedef struct {
+	u_int32  resolution;    /* resolution of the values (us) */
+	/* M_open (PROFIDP_Init) */
+	u_int32  fwValidate;    /* check firmware image and loaded firmware (CRC) */
+	u_int32  fwLoad;        /* load firmware segments */
+	u_int32  fwVerify;      /* verify firmware segments */
+	/* PROFIDP_BLK_CONFIG */
+	u_int32  cmiReady;      /* wait for controller ready mask */
+	u_int32  cmiConfigMode; /* wait for controller CONFIG_MODE */
+	u_int32  cmiInit;       /* CMI initialization, total */
+	u_int32  fmbSetConfig;  /* FMB_SET_CONFIGURATION */
+	u_int32  dpInitMaster;  /* DP_INIT_MASTER */
+	u_int32  busParaDl;     /* download of bus parameter set */
+	u_int32  slaveParaDl;   /* download of all slave parameter sets */
+	u_int32  config;        /* PROFIDP_BLK_CONFIG, total */
+	/* PROFIDP_START_STACK */
+	u_int32  stackStop;     /* set state STOP */
+	u_int32  stackClear;    /* set state CLEAR */
+	u_int32  stackOperate;  /* set state OPERATE */
+	u_int32  slaveDl[PROFIDP_STARTUP_SLAVES]; /* download per slave parameter set */
+} PROFIDP_STARTUP_TIME;
+
+/* live list for PROFIDP_BLK_LIVE_LIST (bit n%8 of byte n/8 = slave address n) */
+typedef struct {
+	u_int32  gen;         /* incremented when live or diag changed */
+	u_int8   live[16];    /* configured slave in data exchange (PROFIDP_CHANGED_SIZE) */
+	u_int8   diag[16];    /* slave station has diag data (PROFIDP_CHANGED_SIZE) */
+} PROFIDP_LIVE_LIST;
+
+/* slave diag change record for PROFIDP_BLK_GET_DIAG_HIST */
+#define PROFIDP_DIAG_HIST_DATA  32   /* stored bytes of diag data */
+typedef struct {
+	u_int64  time;        /* time of reception (us, see PROFIDP_STARTUP_TIME) */
+	u_int32  seq;         /* running record nbr, gaps = records lost */
+	u_int8   addr;        /* slave address */
+	u_int8   _pad;
+	u_int16  len;         /* diag data length (data truncated if larger) */
+	u_int8   data[PROFIDP_DIAG_HIST_DATA]; /* T_DP_DIAG_DATA + ext. diag */
+} PROFIDP_DIAG_REC;
 
 /*-----------------------------------------+
 |  DEFINES                                 |
 +-----------------------------------------*/
+/* size of bitmap returned by PROFIDP_BLK_GET_CHANGED and
+   PROFIDP_BLK_GET_NEW_DIAG (bit n = slave address n) */
+#define PROFIDP_CHANGED_SIZE       16
 
 /* PROFIDP specific status codes (STD) */			/* S,G: S=setstat, G=getstat */
 #define PROFIDP_SIG_ON_EVENT_SET   M_DEV_OF+0x00	/* S: install signal */
@@ -73,6 +180,29 @@
 #define PROFIDP_MAX_OUTPUT_LEN     M_DEV_OF+0x0c    /* G: get max slave output length */
 #define PROFIDP_CH_INPUT_LEN       M_DEV_OF+0x0d    /* G: get slave input length */
 #define PROFIDP_CH_OUTPUT_LEN      M_DEV_OF+0x0e    /* G: get slave output length */
+#define PROFIDP_SNAPSHOT_PERIOD    M_DEV_OF+0x0f    /* S,G: input snapshot period (ms), 0=off */
+#define PROFIDP_SNAPSHOT_AGE       M_DEV_OF+0x10    /* G: age of input snapshot (ms) */
+#define PROFIDP_FLUSH_PERIOD       M_DEV_OF+0x11    /* S,G: output shadow flush period (ms), 0=off */
+#define PROFIDP_FLUSH_OUTPUTS      M_DEV_OF+0x12    /* S: flush dirty outputs of shadow now */
+#define PROFIDP_SIG_ON_CHANGE      M_DEV_OF+0x13    /* S,G: send signal on input change, 0=off */
+#define PROFIDP_CONFLICT_TIMEOUT   M_DEV_OF+0x14    /* S,G: max wait (ms) for data descr semaphore */
+#define PROFIDP_CONFLICT_SPIN      M_DEV_OF+0x15    /* S,G: nbr of retries before backing off */
+#define PROFIDP_CONFLICT_STAT_CLR  M_DEV_OF+0x16    /* S: clear conflict statistics */
+#define PROFIDP_CON_IND_POLICY     M_DEV_OF+0x17    /* S,G: CON/IND buffer overflow policy */
+#define PROFIDP_CON_IND_OVERFLOWS  M_DEV_OF+0x18    /* S,G: nbr of lost CON/INDs, S: clear */
+#define PROFIDP_CON_IND_HWM        M_DEV_OF+0x19    /* S,G: max nbr of CON/INDs in buffer, S: clear */
+#define PROFIDP_ASYNC_PENDING      M_DEV_OF+0x1a    /* G: nbr of submitted, not reaped requests */
+#define PROFIDP_SLAVE_ACTIVE       M_DEV_OF+0x1b    /* S: activate (1) or deactivate (0) slave ch */
+#define PROFIDP_CONFIG_HASH        M_DEV_OF+0x1c    /* G: hash of current configuration, 0=none */
+#define PROFIDP_REATTACHED         M_DEV_OF+0x1d    /* G: running firmware re-attached by M_open */
+#define PROFIDP_DIAG_GEN           M_DEV_OF+0x1e    /* G: nbr of diag changes of slave ch */
+#define PROFIDP_ALIVE_PERIOD       M_DEV_OF+0x1f    /* S,G: firmware alive check period (ms), 0=off */
+#define PROFIDP_FW_ALIVE           M_DEV_OF+0x20    /* G: result of last firmware alive check */
+
+/* CON/IND buffer overflow policies for PROFIDP_CON_IND_POLICY */
+#define PROFIDP_CON_IND_DROP_NEWEST  0  /* new CON/IND is lost (default) */
+#define PROFIDP_CON_IND_DROP_OLDEST  1  /* oldest CON/IND is overwritten */
+#define PROFIDP_CON_IND_BLOCK        2  /* queued until space is free (max. 4) */
 
 
 /* PROFIDP specific status codes (BLK)	*/			/* S,G: S=setstat, G=getstat */
@@ -86,6 +216,18 @@
 #define   PROFIDP_BLK_GET_CON_IND      M_DEV_BLK_OF+0x07 /* G: get CON/IND form buffer */
 #define   PROFIDP_BLK_RCV_CON_IND      M_DEV_BLK_OF+0x08 /* G: receive CON/IND M57 */
 #define   PROFIDP_BLK_RCV_CON_IND_WAIT M_DEV_BLK_OF+0x09 /* G: receive CON/IND M57 and wait until CON/IND occurs*/
+#define   PROFIDP_BLK_GET_CH_LIST      M_DEV_BLK_OF+0x0a /* G: read data from list of channels */
+#define   PROFIDP_BLK_SET_CH_LIST      M_DEV_BLK_OF+0x0b /* S: write data to list of channels */
+#define   PROFIDP_BLK_GET_CHANGED      M_DEV_BLK_OF+0x0c /* G: get and clear changed inputs bitmap */
+#define   PROFIDP_BLK_CONFLICT_STAT    M_DEV_BLK_OF+0x0d /* G: get conflict statistics */
+#define   PROFIDP_BLK_RCV_CON_IND_MULTI M_DEV_BLK_OF+0x0e /* S: receive as many CON/INDs as fit */
+#define   PROFIDP_BLK_SUBMIT_REQ       M_DEV_BLK_OF+0x0f /* S: submit request, don't wait for CON */
+#define   PROFIDP_BLK_REAP_CPL         M_DEV_BLK_OF+0x10 /* G: get completions of submitted requests */
+#define   PROFIDP_BLK_SLAVE_PARAM      M_DEV_BLK_OF+0x11 /* S: download parameter set of one slave */
+#define   PROFIDP_BLK_STARTUP_TIME     M_DEV_BLK_OF+0x12 /* G: get startup phase times */
+#define   PROFIDP_BLK_GET_NEW_DIAG     M_DEV_BLK_OF+0x13 /* G: get and clear new slave diag bitmap */
+#define   PROFIDP_BLK_GET_DIAG_HIST    M_DEV_BLK_OF+0x14 /* G: get and remove diag history records */
+#define   PROFIDP_BLK_LIVE_LIST        M_DEV_BLK_OF+0x15 /* G: get live list from DP status image */
 
 /*--- PROFIDP specific error codes ---*/
 #define PROFIDP_ERR_VERIFY_FW         (ERR_DEV+0x1)   /* error verify firmware */
@@ -106,6 +248,9 @@
 #define PROFIDP_ERR_REQ_CON_TIMEOUT   (ERR_DEV+0x10)  /* timeout error during REQ or CON  */
 #define PROFIDP_ERR_FW_NOT_ALIVE      (ERR_DEV+0x11)  /* PROFIDP-Firmware is not alive  */
 #define PROFIDP_ERR_CREATING_ISR_TASK (ERR_DEV+0x12)  /* error creating ISR task */
+#define PROFIDP_ERR_NO_REQ_SLOT       (ERR_DEV+0x13)  /* no free request descriptor */
+#define PROFIDP_ERR_SLAVE_PARAM       (ERR_DEV+0x14)  /* error download/activate slave parameters */
+#define PROFIDP_ERR_CREATING_TASK     (ERR_DEV+0x15)  /* error creating snapshot/flush/submission/alive task */
 
 /*
  * Macros to build unique, variant specific names for global symbols